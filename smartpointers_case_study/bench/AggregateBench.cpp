@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "Aggregate.h"
+#include "Benchmark.h"
+#include "Engine.h"
+#include "Fridge.h"
+
+/*size Fridges whose impl owns an Engine graph, an ElectricEngine, a Compressor and a Thermostat:
+with a unique_ptr pimpl and a unique_ptr per component (4 blocks per Fridge, the impl and its 3
+components), and with makeAggregate (one block). coolDown() goes through all the components, once
+in the order of construction, where malloc tends to have put the blocks of a Fridge next to each
+other, and once in a shuffled order, like Fridges reached through a hash map or a graph. The cache
+misses are those of the hardware counter when the system lets the benchmark open it; the cache
+lines are counted from the addresses, so they don't depend on it. The Fridge of Fridge.h, whose
+impl is inline and whose Engine is empty, is the reference of what no indirection at all costs.*/
+
+namespace
+{
+class ElectricEngine : public Engine
+{
+    public:
+        double power = 150.0;
+        double efficiency = 0.8;
+};
+
+struct Compressor
+{
+    double pressure = 1.2;
+    std::uint64_t cycles = 0;
+};
+
+struct Thermostat
+{
+    double target = 4.0;
+    double measured = 7.0;
+};
+
+double coolDown(ElectricEngine const& engine, Compressor& compressor, Thermostat& thermostat)
+{
+    ++compressor.cycles;
+    thermostat.measured -= engine.power * engine.efficiency * compressor.pressure * 1e-6;
+    return thermostat.measured - thermostat.target;
+}
+
+class ScatteredImpl
+{
+    public:
+        double coolDown() { return ::coolDown(*engine_, *compressor_, *thermostat_); }
+        std::vector<std::pair<void const*, std::size_t>> blocks() const
+        {
+            return {{this, sizeof *this}, {engine_.get(), sizeof *engine_}, {compressor_.get(), sizeof *compressor_},
+                    {thermostat_.get(), sizeof *thermostat_}};
+        }
+    private:
+        std::unique_ptr<ElectricEngine> engine_ = std::make_unique<ElectricEngine>();
+        std::unique_ptr<Compressor> compressor_ = std::make_unique<Compressor>();
+        std::unique_ptr<Thermostat> thermostat_ = std::make_unique<Thermostat>();
+};
+
+class AggregateImpl
+{
+    public:
+        AggregateImpl(ElectricEngine& engine, Compressor& compressor, Thermostat& thermostat)
+            : engine_(engine), compressor_(compressor), thermostat_(thermostat)
+        {
+        }
+        double coolDown() { return ::coolDown(*engine_, *compressor_, *thermostat_); }
+        std::vector<std::pair<void const*, std::size_t>> blocks() const
+        {
+            return {{this, sizeof *this}, {engine_.get(), sizeof *engine_}, {compressor_.get(), sizeof *compressor_},
+                    {thermostat_.get(), sizeof *thermostat_}};
+        }
+    private:
+        util::Attached<ElectricEngine> engine_;
+        util::Attached<Compressor> compressor_;
+        util::Attached<Thermostat> thermostat_;
+};
+
+struct ScatteredFridge
+{
+    std::unique_ptr<ScatteredImpl> impl = std::make_unique<ScatteredImpl>();
+};
+
+struct AggregateFridge
+{
+    util::AggregatePtr<AggregateImpl> impl = util::makeAggregate<AggregateImpl, ElectricEngine, Compressor, Thermostat>();
+};
+
+//The distinct 64-byte lines that a coolDown() of impl reads or writes
+template<typename Impl>
+double cacheLines(Impl const& impl)
+{
+    std::vector<std::uintptr_t> lines;
+    for (auto const& block : impl.blocks())
+    {
+        auto const first = reinterpret_cast<std::uintptr_t>(block.first);
+        for (std::uintptr_t line = first / 64; line <= (first + block.second - 1) / 64; ++line)
+        {
+            lines.push_back(line);
+        }
+    }
+    std::sort(lines.begin(), lines.end());
+    return static_cast<double>(std::unique(lines.begin(), lines.end()) - lines.begin());
+}
+
+template<typename Fridges>
+void coolDowns(std::string const& prefix, Fridges& fridges, std::vector<std::size_t> const& order)
+{
+    std::size_t const size = fridges.size();
+    bench::CacheMissCounter counter;
+    double sum = 0;
+    counter.start();
+    double const nanoseconds = bench::measure(size, [&](std::size_t i)
+    {
+        sum += fridges[order[i]].impl->coolDown();
+    });
+    double const misses = counter.stop();
+    bench::doNotOptimize(sum);
+    bench::report(prefix + "coolDown()", nanoseconds);
+    if (misses >= 0)
+    {
+        bench::report(prefix + "cache misses per coolDown()", misses / size, "misses");
+    }
+}
+
+template<typename Fridge>
+void layout(std::string const& name, std::size_t size, std::vector<std::size_t> const& shuffled)
+{
+    std::vector<Fridge> fridges;
+    fridges.reserve(size);
+    bench::report(name + ", construction", bench::measure(size, [&fridges](std::size_t)
+    {
+        fridges.emplace_back();
+    }));
+    bench::report(name + ", bytes per Fridge", static_cast<double>(sizeof(Fridge)) + [&fridges]
+    {
+        std::size_t bytes = 0;
+        for (auto const& block : fridges.front().impl->blocks())
+        {
+            bytes += block.second;
+        }
+        return bytes;
+    }(), "bytes");
+    double lines = 0;
+    for (std::size_t i = 0; i < size; i += 97)
+    {
+        lines += cacheLines(*fridges[i].impl);
+    }
+    bench::report(name + ", cache lines per coolDown()", lines / ((size + 96) / 97), "lines");
+
+    std::vector<std::size_t> inOrder(size);
+    std::iota(inOrder.begin(), inOrder.end(), 0);
+    coolDowns(name + ", in order, ", fridges, inOrder);
+    coolDowns(name + ", shuffled, ", fridges, shuffled);
+    bench::report(name + ", destruction", bench::measure(1, [&fridges](std::size_t)
+    {
+        std::vector<Fridge>().swap(fridges);
+    }) / size);
+}
+
+void current(std::size_t size, std::vector<std::size_t> const& shuffled)
+{
+    std::vector<::Fridge> fridges;
+    bench::report("Fridge (inline impl), construction", bench::measure(1, [&fridges, size](std::size_t)
+    {
+        std::vector<::Fridge>(size).swap(fridges);
+    }) / size);
+    bench::report("Fridge (inline impl), shuffled, coolDown()", bench::measure(size, [&](std::size_t i)
+    {
+        fridges[shuffled[i]].coolDown();
+    }));
+}
+
+void run(std::size_t size)
+{
+    std::vector<std::size_t> shuffled(size);
+    std::iota(shuffled.begin(), shuffled.end(), 0);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64(42));
+
+    layout<ScatteredFridge>("unique_ptr per component", size, shuffled);
+    layout<AggregateFridge>("makeAggregate", size, shuffled);
+    current(size, shuffled);
+}
+
+bench::Registration registration("Fridge Engine graph, one block vs a block per component", run);
+}
@@ -0,0 +1,74 @@
+#include <memory>
+#include <vector>
+#include "Arena.h"
+#include "ArenaFridge.h"
+#include "Benchmark.h"
+#include "Fridge.h"
+#include "LegacyFridge.h"
+
+namespace
+{
+//A request-scoped batch of Fridges, released one by one
+void batchOneByOne(std::size_t size)
+{
+    std::vector<std::unique_ptr<LegacyFridge>> fridges;
+    fridges.reserve(size);
+    bench::report("batch of unique_ptr pimpl Fridges, new/delete", bench::measure(size, [&fridges](std::size_t)
+    {
+        fridges.push_back(std::make_unique<LegacyFridge>());
+    }) + bench::measure(1, [&fridges](std::size_t)
+    {
+        fridges.clear();
+    }) / size);
+}
+
+//The same batch built in an arena and released by a single reset(): the FridgeImpls are inside the Fridges
+void batchArena(std::size_t size)
+{
+    util::Arena arena;
+    std::vector<Fridge*> fridges;
+    fridges.reserve(size);
+    bench::report("batch of arena Fridges, Arena::reset", bench::measure(size, [&](std::size_t)
+    {
+        fridges.push_back(arena.create<Fridge>());
+    }) + bench::measure(1, [&arena](std::size_t)
+    {
+        arena.reset();
+    }) / size);
+}
+
+//With an impl that has to stay out of the object, both come from the arena
+void batchArenaPimpl(std::size_t size)
+{
+    util::Arena arena;
+    std::vector<ArenaFridge*> fridges;
+    fridges.reserve(size);
+    bench::report("batch of arena ArenaPimpl Fridges, Arena::reset", bench::measure(size, [&](std::size_t)
+    {
+        fridges.push_back(arena.create<ArenaFridge>(arena));
+    }) + bench::measure(1, [&arena](std::size_t)
+    {
+        arena.reset();
+    }) / size);
+}
+
+void constructDestroyArena(std::size_t size)
+{
+    util::Arena& arena = util::Arena::threadLocal();
+    bench::report("construct/destroy Fridge with FridgeImpl in arena", bench::measure(size, [&arena](std::size_t)
+    {
+        ArenaFridge fridge(arena);
+        bench::doNotOptimize(fridge);
+    }));
+}
+
+void run(std::size_t size)
+{
+    batchOneByOne(size);
+    batchArena(size);
+    batchArenaPimpl(size);
+    constructDestroyArena(size);
+}
+
+bench::Registration registration("Arena pimpl", run);
+}
@@ -0,0 +1,21 @@
+#include "ArenaFridge.h"
+#include "Engine.h"
+
+class ArenaFridge::FridgeImpl
+{
+    public:
+        void coolDown(){
+            //
+        }
+    private:
+        Engine engine_;
+};
+
+ArenaFridge::ArenaFridge() = default;
+ArenaFridge::ArenaFridge(util::Arena& arena) : impl_(arena) {}
+ArenaFridge::~ArenaFridge() = default;
+
+void ArenaFridge::coolDown()
+{
+    impl_->coolDown();
+}
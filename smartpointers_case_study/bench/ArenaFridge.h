@@ -0,0 +1,19 @@
+#ifndef ARENAFRIDGE_H
+#define ARENAFRIDGE_H
+#include "Arena.h"
+
+/*Fridge as it would be written if the size of FridgeImpl couldn't be fixed in the header: the impl
+stays out of the object, but comes from an arena instead of new*/
+class ArenaFridge
+{
+    public:
+        ArenaFridge();
+        explicit ArenaFridge(util::Arena& arena);
+        ~ArenaFridge();
+        void coolDown();
+    private:
+        class FridgeImpl;
+        util::ArenaPimpl<FridgeImpl> impl_;
+};
+
+#endif // ARENAFRIDGE_H
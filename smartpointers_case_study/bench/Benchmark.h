@@ -0,0 +1,72 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/*A very small benchmark harness: each benchmark file registers its functions with a static
+Registration object, and bench/main.cpp runs them all (or only those whose name contains the
+filter given on the command line).*/
+
+/*bench/main.cpp runs each registered function once to warm up, then --repetitions times. Each
+run rebuilds its own data, so a function may measure code that consumes it. Every value given to
+report() becomes one sample of its line: the lines are printed with the median, the spread and
+the minimum of their samples once the repetitions are over, and --json=file writes all the
+samples.*/
+
+namespace bench
+{
+using Clock = std::chrono::steady_clock;
+
+//Keeps the optimizer from removing a computation whose result is otherwise unused
+template<typename T>
+inline void doNotOptimize(T const& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+//Runs f(i) for every i in [0, iterations) and returns the average time of one call in nanoseconds
+template<typename F>
+double measure(std::size_t iterations, F&& f)
+{
+    auto const start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        f(i);
+    }
+    auto const elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+    return elapsed.count() / iterations;
+}
+
+//Adds a sample to the line name of the benchmark that is running
+void report(std::string const& name, double value, char const* unit = "ns");
+
+/*Counts the cache misses of the calling thread between start() and stop(), with perf_event_open.
+stop() returns -1 where the counter can't be opened: outside of Linux, when perf_event_paranoid
+forbids it, or in a virtual machine that doesn't expose the hardware counters.*/
+class CacheMissCounter
+{
+    public:
+        CacheMissCounter();
+        ~CacheMissCounter();
+        CacheMissCounter(const CacheMissCounter&) = delete;
+        CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+        bool available() const noexcept { return descriptor_ >= 0; }
+        void start();
+        double stop();
+
+    private:
+        int descriptor_;
+};
+
+//size is a number of elements or iterations that each benchmark scales its work on
+using Function = void(*)(std::size_t size);
+
+struct Registration
+{
+    Registration(char const* name, Function function);
+};
+}
+
+#endif // BENCHMARK_H
@@ -0,0 +1,171 @@
+#include <memory>
+#include "Arena.h"
+#include "Benchmark.h"
+#include "Cloneable.h"
+
+/*Deep copy of a binary tree of size nodes, with leaves and branches of different types: with the
+hand-written cloneBase() of main.cpp, with Cloneable::clone() on the heap, and with
+Cloneable::clone(arena) into one arena chunk big enough for the whole tree.*/
+
+namespace
+{
+namespace handWritten
+{
+class Node
+{
+    public:
+        virtual ~Node() = default;
+        virtual std::unique_ptr<Node> cloneBase() const = 0;
+        virtual long sum() const = 0;
+};
+
+class Leaf : public Node
+{
+    public:
+        explicit Leaf(long value) : value_(value) {}
+        std::unique_ptr<Node> cloneBase() const override
+        {
+            return std::make_unique<Leaf>(*this);
+        }
+        long sum() const override { return value_; }
+    private:
+        long value_;
+};
+
+class Branch : public Node
+{
+    public:
+        Branch(std::unique_ptr<Node> left, std::unique_ptr<Node> right) : left_(std::move(left)), right_(std::move(right)) {}
+        Branch(const Branch& other) : left_(other.left_->cloneBase()), right_(other.right_->cloneBase()) {}
+        std::unique_ptr<Node> cloneBase() const override
+        {
+            return std::make_unique<Branch>(*this);
+        }
+        long sum() const override { return left_->sum() + right_->sum(); }
+    private:
+        std::unique_ptr<Node> left_;
+        std::unique_ptr<Node> right_;
+};
+}
+
+namespace crtp
+{
+class Node : public util::Cloneable<util::Abstract<Node>>
+{
+    public:
+        virtual long sum() const = 0;
+};
+
+class Leaf : public util::Cloneable<Leaf, Node>
+{
+    public:
+        explicit Leaf(long value) : value_(value) {}
+        long sum() const override { return value_; }
+    private:
+        long value_;
+};
+
+class Branch : public util::Cloneable<Branch, Node>
+{
+    public:
+        Branch(util::ClonePtr<Node> left, util::ClonePtr<Node> right) : left_(std::move(left)), right_(std::move(right)) {}
+        Branch(const Branch& other) : Cloneable(other), left_(other.left_->clone()), right_(other.right_->clone()) {}
+        //Used by clone(arena): the children go to the same arena
+        Branch(const Branch& other, util::Arena& arena)
+            : Cloneable(other), left_(other.left_->clone(arena)), right_(other.right_->clone(arena)) {}
+        long sum() const override { return left_->sum() + right_->sum(); }
+    private:
+        util::ClonePtr<Node> left_;
+        util::ClonePtr<Node> right_;
+};
+}
+
+//Every branch has two children, so count is odd, and so are the sizes of the two subtrees
+template<typename Pointer, typename Leaf, typename Branch>
+Pointer build(std::size_t count, long& next)
+{
+    if (count == 1)
+    {
+        return Pointer(new Leaf(next++));
+    }
+    std::size_t const left = (count - 1) / 2 % 2 ? (count - 1) / 2 : (count - 1) / 2 - 1;
+    Pointer leftTree = build<Pointer, Leaf, Branch>(left, next);
+    Pointer rightTree = build<Pointer, Leaf, Branch>(count - 1 - left, next);
+    return Pointer(new Branch(std::move(leftTree), std::move(rightTree)));
+}
+
+void handWrittenCopy(std::size_t size)
+{
+    using namespace handWritten;
+    long next = 0;
+    std::unique_ptr<Node> const tree = build<std::unique_ptr<Node>, Leaf, Branch>(size, next);
+    std::unique_ptr<Node> copy;
+    bench::report("cloneBase(), copy per node", bench::measure(1, [&](std::size_t)
+    {
+        copy = tree->cloneBase();
+    }) / size);
+    bench::doNotOptimize(copy->sum());
+    bench::report("cloneBase(), delete per node", bench::measure(1, [&](std::size_t)
+    {
+        copy.reset();
+    }) / size);
+}
+
+void heapCopy(std::size_t size)
+{
+    using namespace crtp;
+    long next = 0;
+    util::ClonePtr<Node> const tree = build<util::ClonePtr<Node>, Leaf, Branch>(size, next);
+    std::unique_ptr<Node> copy;
+    bench::report("Cloneable::clone(), copy per node", bench::measure(1, [&](std::size_t)
+    {
+        copy = tree->clone();
+    }) / size);
+    bench::doNotOptimize(copy->sum());
+    bench::report("Cloneable::clone(), delete per node", bench::measure(1, [&](std::size_t)
+    {
+        copy.reset();
+    }) / size);
+}
+
+void arenaCopy(std::size_t size)
+{
+    using namespace crtp;
+    long next = 0;
+    util::ClonePtr<Node> const tree = build<util::ClonePtr<Node>, Leaf, Branch>(size, next);
+    //One chunk for the whole copy: the only allocation is the first one of the arena
+    util::Arena arena(size * 64);
+    util::ClonePtr<Node> copy;
+    bench::report("Cloneable::clone(arena), copy per node", bench::measure(1, [&](std::size_t)
+    {
+        copy = tree->clone(arena);
+    }) / size);
+    bench::doNotOptimize(copy->sum());
+    bench::report("Cloneable::clone(arena), destroy per node", bench::measure(1, [&](std::size_t)
+    {
+        copy.reset();
+    }) / size);
+    //The nodes own nothing outside of the arena: dropping the copy and resetting the arena is enough
+    copy = tree->clone(arena);
+    bench::report("Cloneable::clone(arena), Arena::reset per node", bench::measure(1, [&](std::size_t)
+    {
+        copy.release();
+        arena.reset();
+    }) / size);
+    bench::report("Cloneable::clone(arena), copy per node, arena reused", bench::measure(1, [&](std::size_t)
+    {
+        copy = tree->clone(arena);
+    }) / size);
+    copy.release();
+}
+
+void run(std::size_t size)
+{
+    size |= 1;
+    handWrittenCopy(size);
+    heapCopy(size);
+    arenaCopy(size);
+}
+
+bench::Registration registration("Cloneable tree deep copy vs cloneBase", run);
+}
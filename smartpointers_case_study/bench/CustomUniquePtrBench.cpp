@@ -0,0 +1,75 @@
+#include <vector>
+#include "Benchmark.h"
+#include "CustomUniquePtr.h"
+
+namespace
+{
+class Instructions
+{
+    public:
+        virtual ~Instructions() = default;
+        virtual int steps() const = 0;
+};
+
+class Sketch : public Instructions
+{
+    public:
+        int steps() const override { return 1; }
+};
+
+class Blueprint : public Instructions
+{
+    public:
+        int steps() const override { return 10; }
+};
+
+static_assert(sizeof(util::CustomUniquePtr<Instructions>) == 2 * sizeof(void*), "function pointer deleter");
+static_assert(sizeof(util::TaggedUniquePtr<Instructions>) == sizeof(void*), "tag bit only");
+
+/*One in four Instructions is borrowed from the stack, the others are owned: building the vector,
+reading through it and destroying it measures the deleter choice at each step.*/
+template<typename Pointer, typename MakeOwned, typename MakeBorrowed>
+void measurePointers(char const* name, std::size_t size, MakeOwned makeOwned, MakeBorrowed makeBorrowed)
+{
+    Blueprint blueprint;
+    std::string const prefix(name);
+    bench::report(prefix + " bytes per element", sizeof(Pointer), "B");
+    {
+        std::vector<Pointer> pointers;
+        pointers.reserve(size);
+        bench::report(prefix + " build", bench::measure(size, [&](std::size_t i)
+        {
+            if (i % 4 == 0)
+            {
+                pointers.push_back(makeBorrowed(&blueprint));
+            }
+            else
+            {
+                pointers.push_back(makeOwned(new Sketch));
+            }
+        }));
+        long steps = 0;
+        bench::report(prefix + " read", bench::measure(size, [&](std::size_t i)
+        {
+            steps += pointers[i]->steps();
+        }));
+        bench::doNotOptimize(steps);
+        bench::report(prefix + " destroy", bench::measure(1, [&](std::size_t)
+        {
+            pointers.clear();
+        }) / size);
+    }
+}
+
+void run(std::size_t size)
+{
+    measurePointers<util::CustomUniquePtr<Instructions>>("CustomUniquePtr (function pointer)", size,
+        [](Instructions* p) { return util::CustomUniquePtr<Instructions>(p, util::doDelete<Instructions>); },
+        [](Instructions* p) { return util::CustomUniquePtr<Instructions>(p, util::doNotDelete<Instructions>); });
+    measurePointers<util::TaggedUniquePtr<Instructions>>("TaggedUniquePtr (tag bit)", size,
+        [](Instructions* p) { return util::MakeConstUnique(p); },
+        [](Instructions* p) { return util::MakeConstUniqueNoDelete(p); });
+}
+
+bench::Registration registration("Function pointer vs tag bit deleters", run);
+}
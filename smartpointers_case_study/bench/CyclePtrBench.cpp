@@ -0,0 +1,86 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "CyclePtr.h"
+
+/*Builds and drops size pairs of Houses that are each other's neighbour, as in main.cpp. With
+shared_ptr all of them stay alive; with CyclePtr a background collector reclaims them as it goes.*/
+
+namespace
+{
+//The background collector runs the destructors of the CycleHouses
+std::atomic<long> liveHouses{0};
+
+struct SharedHouse
+{
+    SharedHouse() { ++liveHouses; }
+    ~SharedHouse() { --liveHouses; }
+    std::shared_ptr<SharedHouse> neighbour;
+};
+
+struct CycleHouse : util::Collectable
+{
+    CycleHouse() { ++liveHouses; }
+    ~CycleHouse() { --liveHouses; }
+    void trace(util::CycleTracer& tracer) override { tracer(neighbour); }
+    util::CyclePtr<CycleHouse> neighbour;
+};
+
+void run(std::size_t size)
+{
+    size /= 10;
+    std::vector<std::shared_ptr<SharedHouse>> leaked;
+    leaked.reserve(size);
+    bench::report("shared_ptr pair of neighbours", bench::measure(size, [&](std::size_t)
+    {
+        auto house1 = std::make_shared<SharedHouse>();
+        auto house2 = std::make_shared<SharedHouse>();
+        house1->neighbour = house2;
+        house2->neighbour = house1;
+        //Only kept to break the cycles once the benchmark is over
+        leaked.push_back(house1);
+    }));
+    bench::report("  houses still alive", static_cast<double>(liveHouses), "objects");
+    for (auto& house : leaked)
+    {
+        house->neighbour->neighbour.reset();
+    }
+    leaked.clear();
+
+    util::CycleCollector collector;
+    collector.startBackground(std::chrono::milliseconds(1), 4096);
+    bench::report("CyclePtr pair of neighbours", bench::measure(size, [&](std::size_t)
+    {
+        auto house1 = collector.make<CycleHouse>();
+        auto house2 = collector.make<CycleHouse>();
+        house1->neighbour = house2;
+        house2->neighbour = house1;
+    }));
+    collector.stopBackground();
+    bench::report("  houses still alive", static_cast<double>(liveHouses), "objects");
+    util::CycleCollector::Statistics const statistics = collector.statistics();
+    bench::report("  cycles reclaimed in the background", static_cast<double>(statistics.cyclesReclaimed), "cycles");
+    bench::report("  collections", static_cast<double>(statistics.collections), "collections");
+    bench::report("  longest step", std::chrono::duration<double, std::micro>(statistics.longestPause).count(), "us");
+    collector.collect();
+    bench::report("  houses alive after collect()", static_cast<double>(liveHouses), "objects");
+
+    auto shared = std::make_shared<SharedHouse>();
+    bench::report("shared_ptr copy", bench::measure(size, [&](std::size_t)
+    {
+        std::shared_ptr<SharedHouse> copy = shared;
+        bench::doNotOptimize(copy);
+    }));
+    auto cycle = collector.make<CycleHouse>();
+    bench::report("CyclePtr copy", bench::measure(size, [&](std::size_t)
+    {
+        util::CyclePtr<CycleHouse> copy = cycle;
+        bench::doNotOptimize(copy);
+    }));
+}
+
+bench::Registration registration("CyclePtr vs shared_ptr cycles", run);
+}
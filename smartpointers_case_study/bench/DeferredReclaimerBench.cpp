@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "DeferredReclaimer.h"
+
+/*What the thread that drops a big UniquePointerSet pays, as in the set transfer of main.cpp: with
+the destructor run in place, with the set handed over whole to the reclaimer, and with a deferred
+deleter on each element (the set nodes are still freed in place). Each drop is timed alone, so the
+percentiles are those of the hot thread. The reclaimer shares the cores with it, so on a machine
+with a single core the deletions still happen, just not inside the timed drop.*/
+
+namespace
+{
+class Base
+{
+    public:
+        explicit Base(int id) : id_(id) {}
+        virtual ~Base() = default;
+        int id() const { return id_; }
+    private:
+        int id_;
+        char payload_[48] = {};
+};
+
+class Derived : public Base
+{
+    public:
+        using Base::Base;
+};
+
+bool operator<(Base const& b1, Base const& b2) { return b1.id() < b2.id(); }
+
+//util::ComparePointee, for any deleter
+struct ComparePointee
+{
+    template<typename Pointer>
+    bool operator()(Pointer const& p1, Pointer const& p2) const
+    {
+        return *p1 < *p2;
+    }
+};
+
+template<typename Pointer>
+using Set = std::set<Pointer, ComparePointee>;
+
+template<typename Pointer>
+Set<Pointer> makeSet(std::size_t elements)
+{
+    Set<Pointer> set;
+    for (std::size_t i = 0; i < elements; ++i)
+    {
+        set.insert(Pointer(new Derived(static_cast<int>(i))));
+    }
+    return set;
+}
+
+template<typename Pointer, typename Drop>
+void drops(std::string const& name, std::size_t elements, std::size_t iterations, Drop drop)
+{
+    std::vector<double> latencies;
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        Set<Pointer> set = makeSet<Pointer>(elements);
+        auto const before = bench::Clock::now();
+        drop(set);
+        latencies.push_back(std::chrono::duration<double, std::micro>(bench::Clock::now() - before).count());
+    }
+    util::DeferredReclaimer::global().flush();
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) { return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))]; };
+    std::string const prefix = name + ", " + std::to_string(elements) + " elements, ";
+    bench::report(prefix + "p50", percentile(0.50), "us");
+    bench::report(prefix + "p99", percentile(0.99), "us");
+    bench::report(prefix + "max", latencies.back(), "us");
+}
+
+void setTeardown(std::size_t size)
+{
+    std::size_t const elements = std::max<std::size_t>(size / 100, 1);
+    std::size_t const iterations = 100;
+    drops<std::unique_ptr<Base>>("destructor in place", elements, iterations, [](Set<std::unique_ptr<Base>>& set)
+    {
+        Set<std::unique_ptr<Base>>().swap(set);
+    });
+    drops<std::unique_ptr<Base>>("deferDestruction(set)", elements, iterations, [](Set<std::unique_ptr<Base>>& set)
+    {
+        util::deferDestruction(std::move(set));
+    });
+    drops<util::DeferredUniquePtr<Base>>("DeferredDelete per element", elements, iterations, [](Set<util::DeferredUniquePtr<Base>>& set)
+    {
+        Set<util::DeferredUniquePtr<Base>>().swap(set);
+    });
+}
+
+//The cost of retire() itself, and what the back-pressure does when the reclaimer can't keep up
+void retireCost(std::size_t size)
+{
+    bench::report("new + delete", bench::measure(size, [](std::size_t i)
+    {
+        Base* object = new Derived(static_cast<int>(i));
+        bench::doNotOptimize(object);
+        delete object;
+    }));
+    bench::report("new + retire", bench::measure(size, [](std::size_t i)
+    {
+        util::DeferredReclaimer::global().retire(new Derived(static_cast<int>(i)));
+    }));
+    util::DeferredReclaimer::global().flush();
+
+    using Overflow = util::DeferredReclaimer::Overflow;
+    for (Overflow overflow : {Overflow::DeleteInline, Overflow::Wait})
+    {
+        std::string const name = overflow == Overflow::DeleteInline ? "capacity 1024, DeleteInline, " : "capacity 1024, Wait, ";
+        util::DeferredReclaimer reclaimer(1024, overflow);
+        bench::report(name + "new + retire", bench::measure(size, [&reclaimer](std::size_t i)
+        {
+            reclaimer.retire(new Derived(static_cast<int>(i)));
+        }));
+        reclaimer.flush();
+        auto const statistics = reclaimer.statistics();
+        bench::report(name + "deleted inline", 100.0 * statistics.deletedInline / size, "%");
+        bench::report(name + "retire() calls that waited", 100.0 * statistics.waits / size, "%");
+        bench::report(name + "objects per batch", static_cast<double>(statistics.reclaimed) / std::max<std::uint64_t>(statistics.batches, 1), "objects");
+    }
+}
+
+void run(std::size_t size)
+{
+    setTeardown(size);
+    retireCost(size);
+}
+
+bench::Registration registration("DeferredReclaimer vs teardown in place", run);
+}
@@ -0,0 +1,92 @@
+#include <cstdlib>
+#include <vector>
+#include "Benchmark.h"
+#include "CustomUniquePtr.h"
+#include "DeleterTraits.h"
+
+namespace
+{
+//A legacy C type with its own deallocation function, like Gizmo in main.cpp
+struct Gizmo
+{
+    long parts;
+};
+
+Gizmo* oldFunctionThatAllocatesAGizmo()
+{
+    Gizmo* gizmo = static_cast<Gizmo*>(std::malloc(sizeof(Gizmo)));
+    gizmo->parts = 1;
+    return gizmo;
+}
+
+void oldFunctionThatDeallocatesAGizmo(Gizmo* gizmo)
+{
+    std::free(gizmo);
+}
+
+void oldFunctionThatDeallocatesAConstGizmo(const Gizmo* gizmo)
+{
+    std::free(const_cast<Gizmo*>(gizmo));
+}
+}
+
+namespace util
+{
+template<>
+struct DeleterTraits<Gizmo>
+{
+    static void dispose(Gizmo* gizmo)
+    {
+        oldFunctionThatDeallocatesAGizmo(gizmo);
+    }
+};
+}
+
+namespace
+{
+using FunctionPointerGizmoPtr = util::CustomUniquePtr<Gizmo>;
+using TraitsGizmoPtr = util::TraitsUniquePtr<Gizmo>;
+using TemplateArgumentGizmoPtr = std::unique_ptr<Gizmo, util::FunctionDeleter<Gizmo, oldFunctionThatDeallocatesAGizmo>>;
+
+static_assert(sizeof(FunctionPointerGizmoPtr) == 2 * sizeof(Gizmo*), "the function pointer is stored");
+static_assert(sizeof(TraitsGizmoPtr) == sizeof(Gizmo*), "the traits deleter is empty");
+static_assert(sizeof(TemplateArgumentGizmoPtr) == sizeof(Gizmo*), "the function is a template argument");
+static_assert(sizeof(util::TaggedUniquePtr<Gizmo>) == sizeof(Gizmo*), "the tag is in the pointer");
+
+template<typename Pointer, typename Make>
+void createDestroy(char const* name, std::size_t size, Make make)
+{
+    std::vector<Pointer> pointers;
+    pointers.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        pointers.push_back(make());
+    }
+    bench::report(name, bench::measure(1, [&](std::size_t)
+    {
+        pointers.clear();
+    }) / size);
+}
+
+void run(std::size_t size)
+{
+    createDestroy<FunctionPointerGizmoPtr>("destroy, function pointer deleter", size, []
+    {
+        return FunctionPointerGizmoPtr(oldFunctionThatAllocatesAGizmo(), oldFunctionThatDeallocatesAConstGizmo);
+    });
+    createDestroy<TraitsGizmoPtr>("destroy, DeleterTraits", size, []
+    {
+        return util::MakeTraitsUnique(oldFunctionThatAllocatesAGizmo());
+    });
+    createDestroy<TemplateArgumentGizmoPtr>("destroy, FunctionDeleter", size, []
+    {
+        return TemplateArgumentGizmoPtr(oldFunctionThatAllocatesAGizmo());
+    });
+    createDestroy<util::TaggedUniquePtr<Gizmo>>("destroy, MakeConstUnique with DeleterTraits", size, []
+    {
+        return util::MakeConstUnique(oldFunctionThatAllocatesAGizmo());
+    });
+}
+
+bench::Registration registration("Specific deleters: function pointer vs traits", run);
+}
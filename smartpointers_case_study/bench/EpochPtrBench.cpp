@@ -0,0 +1,74 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Benchmark.h"
+#include "EpochPtr.h"
+
+/*A routing table read by every thread and replaced once every ratio operations. The shared_ptr
+version is the one C++14 offers: std::atomic_load and std::atomic_store on a shared_ptr.*/
+
+namespace
+{
+struct RoutingTable
+{
+    explicit RoutingTable(int version) : routes(64, version) {}
+    std::vector<int> routes;
+};
+
+template<typename Read, typename Write>
+double throughput(unsigned threadCount, std::size_t operations, std::size_t ratio, Read read, Write write)
+{
+    std::vector<std::thread> threads;
+    auto const start = bench::Clock::now();
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            long sum = 0;
+            for (std::size_t i = 0; i < operations; ++i)
+            {
+                if ((i + t) % ratio == 0)
+                {
+                    write(static_cast<int>(i));
+                }
+                else
+                {
+                    sum += read(i % 64);
+                }
+            }
+            bench::doNotOptimize(sum);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    double const seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+    return threadCount * operations / seconds / 1e6;
+}
+
+void run(std::size_t size)
+{
+    auto shared = std::make_shared<const RoutingTable>(0);
+    util::EpochPtr<RoutingTable> epoch(std::make_unique<RoutingTable>(0));
+    for (std::size_t ratio = 100; ratio <= 10000; ratio *= 10)
+    {
+        for (unsigned threadCount = 1; threadCount <= 64; threadCount *= 2)
+        {
+            std::size_t const operations = std::max<std::size_t>(size / threadCount, ratio);
+            std::string const prefix = std::to_string(ratio) + ":1 reads, " + std::to_string(threadCount) + " threads, ";
+            bench::report(prefix + "atomic_load(shared_ptr)", throughput(threadCount, operations, ratio,
+                [&](std::size_t i) { return std::atomic_load(&shared)->routes[i]; },
+                [&](int version) { std::atomic_store(&shared, std::make_shared<const RoutingTable>(version)); }), "M ops/s");
+            bench::report(prefix + "EpochPtr", throughput(threadCount, operations, ratio,
+                [&](std::size_t i) { return epoch.read()->routes[i]; },
+                [&](int version) { epoch.store(std::make_unique<RoutingTable>(version)); }), "M ops/s");
+        }
+    }
+    util::Epoch::reclaim();
+}
+
+bench::Registration registration("EpochPtr vs atomic shared_ptr", run);
+}
@@ -0,0 +1,37 @@
+#include <vector>
+#include "Benchmark.h"
+#include "Fridge.h"
+#include "LegacyFridge.h"
+
+namespace
+{
+template<typename FridgeType>
+void constructDestroy(char const* name, std::size_t size)
+{
+    bench::report(name, bench::measure(size, [](std::size_t)
+    {
+        FridgeType fridge;
+        bench::doNotOptimize(fridge);
+    }));
+}
+
+template<typename FridgeType>
+void callCoolDown(char const* name, std::size_t size)
+{
+    std::vector<FridgeType> fridges(size);
+    bench::report(name, bench::measure(size, [&fridges](std::size_t i)
+    {
+        fridges[i].coolDown();
+    }));
+}
+
+void run(std::size_t size)
+{
+    constructDestroy<LegacyFridge>("construct/destroy unique_ptr pimpl", size);
+    constructDestroy<Fridge>("construct/destroy inline pimpl", size);
+    callCoolDown<LegacyFridge>("coolDown unique_ptr pimpl", size);
+    callCoolDown<Fridge>("coolDown inline pimpl", size);
+}
+
+bench::Registration registration("FastPimpl vs unique_ptr pimpl", run);
+}
@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Benchmark.h"
+#include "Fridge.h"
+#include "ThreadPool.h"
+
+/*FridgeImpl::coolDown() doesn't do anything yet, so this measures what the batching itself costs
+per Fridge, and how it scales with the number of workers.*/
+
+namespace
+{
+void run(std::size_t size)
+{
+    std::vector<Fridge> fridges(size);
+
+    bench::report("loop of Fridge::coolDown()", bench::measure(1, [&](std::size_t)
+    {
+        for (Fridge& fridge : fridges)
+        {
+            fridge.coolDown();
+        }
+    }) / size);
+
+    unsigned const cores = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned threadCount = 1; threadCount <= cores; threadCount = threadCount < cores ? std::min(threadCount * 2, cores) : cores + 1)
+    {
+        util::ThreadPool pool(threadCount);
+        for (std::size_t chunkSize : {64, 1024, 16384})
+        {
+            bench::report(std::to_string(threadCount) + " workers, chunks of " + std::to_string(chunkSize), bench::measure(1, [&](std::size_t)
+            {
+                Fridge::coolDown(fridges.data(), fridges.size(), pool, chunkSize).get();
+            }) / size);
+        }
+    }
+}
+
+bench::Registration registration("Fridge batched coolDown", run);
+}
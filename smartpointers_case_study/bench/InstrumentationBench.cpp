@@ -0,0 +1,55 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include "Benchmark.h"
+#include "CustomUniquePtr.h"
+#include "Instrumentation.h"
+
+/*The same loops in the Benchmark target, where the hooks are compiled out, and in the Instrumented
+target, where they record every event, then one out of 64. The Instrumented target prints the
+counters as JSON at the end.*/
+
+namespace
+{
+struct Computer
+{
+    int cores = 8;
+};
+
+void loops(std::string const& label, std::size_t size)
+{
+    bench::report(label + "MakeConstUnique + delete", bench::measure(size, [](std::size_t)
+    {
+        auto computer = util::MakeConstUnique(new Computer);
+        bench::doNotOptimize(computer);
+    }));
+    bench::report(label + "makeShared + lock + expired lock", bench::measure(size, [](std::size_t)
+    {
+        std::weak_ptr<Computer> weak;
+        {
+            auto computer = util::instrument::makeSharedAt<Computer>(util::instrument::CallSite::current());
+            weak = computer;
+            bench::doNotOptimize(util::instrument::lock(weak));
+        }
+        bench::doNotOptimize(util::instrument::lock(weak));
+    }));
+}
+
+void run(std::size_t size)
+{
+    //Each repetition dumps its own counters
+    util::instrument::reset();
+    if (!util::instrument::enabled)
+    {
+        loops("compiled out, ", size);
+        return;
+    }
+    util::instrument::setSamplingPeriod(1);
+    loops("every event, ", size);
+    util::instrument::setSamplingPeriod(64);
+    loops("1 event out of 64, ", size);
+    util::instrument::dump(std::cout);
+}
+
+bench::Registration registration("Instrumentation overhead", run);
+}
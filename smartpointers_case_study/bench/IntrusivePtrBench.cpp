@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Benchmark.h"
+#include "IntrusivePtr.h"
+
+namespace
+{
+struct Node
+{
+    long value = 1;
+};
+
+struct SingleThreadedNode : util::RefCounted<util::SingleThreaded>
+{
+    long value = 1;
+};
+
+struct MultiThreadedNode : util::RefCounted<util::MultiThreaded>
+{
+    long value = 1;
+};
+
+template<typename Pointer>
+void copy(char const* name, Pointer const& pointer, std::size_t size)
+{
+    bench::report(name, bench::measure(size, [&pointer](std::size_t)
+    {
+        Pointer copy = pointer;
+        bench::doNotOptimize(copy);
+    }));
+}
+
+template<typename Factory>
+void createDestroy(char const* name, Factory factory, std::size_t size)
+{
+    bench::report(name, bench::measure(size, [&factory](std::size_t)
+    {
+        auto pointer = factory();
+        bench::doNotOptimize(pointer);
+    }));
+}
+
+/*Every object is reached in a random order, so each visit is a cache miss: copying the pointer
+touches the count, reading the value touches the object. With shared_ptr(new T) these are two
+different allocations, with make_shared and intrusive pointers they are next to each other.*/
+template<typename Factory>
+void cacheMisses(char const* name, Factory factory, std::size_t size)
+{
+    using Pointer = decltype(factory());
+    std::vector<Pointer> pointers;
+    pointers.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        pointers.push_back(factory());
+    }
+    std::shuffle(pointers.begin(), pointers.end(), std::mt19937(42));
+    long sum = 0;
+    bench::report(name, bench::measure(size, [&](std::size_t i)
+    {
+        Pointer copy = pointers[i];
+        sum += copy->value;
+    }));
+    bench::doNotOptimize(sum);
+}
+
+void run(std::size_t size)
+{
+    auto newShared = [] { return std::shared_ptr<Node>(new Node); };
+    auto makeShared = [] { return std::make_shared<Node>(); };
+    auto singleThreaded = [] { return util::makeIntrusive<SingleThreadedNode>(); };
+    auto multiThreaded = [] { return util::makeIntrusive<MultiThreadedNode>(); };
+
+    copy("copy std::shared_ptr", makeShared(), size);
+    copy("copy IntrusivePtr SingleThreaded", singleThreaded(), size);
+    copy("copy IntrusivePtr MultiThreaded", multiThreaded(), size);
+
+    createDestroy("create/destroy shared_ptr(new T)", newShared, size);
+    createDestroy("create/destroy make_shared", makeShared, size);
+    createDestroy("create/destroy IntrusivePtr SingleThreaded", singleThreaded, size);
+    createDestroy("create/destroy IntrusivePtr MultiThreaded", multiThreaded, size);
+
+    cacheMisses("random copy+read shared_ptr(new T)", newShared, size);
+    cacheMisses("random copy+read make_shared", makeShared, size);
+    cacheMisses("random copy+read IntrusivePtr SingleThreaded", singleThreaded, size);
+    cacheMisses("random copy+read IntrusivePtr MultiThreaded", multiThreaded, size);
+}
+
+bench::Registration registration("IntrusivePtr vs shared_ptr", run);
+}
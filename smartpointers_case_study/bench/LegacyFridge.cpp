@@ -0,0 +1,20 @@
+#include "Engine.h"
+#include "LegacyFridge.h"
+
+class LegacyFridge::FridgeImpl
+{
+    public:
+        void coolDown(){
+            //
+        }
+    private:
+        Engine engine_;
+};
+
+LegacyFridge::LegacyFridge() : impl_(std::make_unique<FridgeImpl>()) {}
+LegacyFridge::~LegacyFridge() = default;
+
+void LegacyFridge::coolDown()
+{
+    impl_->coolDown();
+}
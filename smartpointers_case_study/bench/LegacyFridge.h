@@ -0,0 +1,17 @@
+#ifndef LEGACYFRIDGE_H
+#define LEGACYFRIDGE_H
+#include <memory>
+
+//Fridge as it was written before FastPimpl, kept as the baseline of the benchmarks
+class LegacyFridge
+{
+    public:
+        LegacyFridge();
+        ~LegacyFridge();
+        void coolDown();
+    private:
+        class FridgeImpl;
+        std::unique_ptr<FridgeImpl> impl_;
+};
+
+#endif // LEGACYFRIDGE_H
@@ -0,0 +1,125 @@
+#include <memory>
+#include <string>
+#include "Arena.h"
+#include "Benchmark.h"
+#include "LinkPtr.h"
+
+/*Destruction of a chain of Houses, each owning its neighbour, and of a binary tree: with
+std::unique_ptr links, destroyed recursively, and with LinkPtr links, destroyed in a loop. The
+unique_ptr chain is kept short enough for the recursion to fit in the default 8 MB stack, the
+LinkPtr chain is 10 times size long (10M nodes by default), and its nodes are counted to check that
+all of them are destroyed.*/
+
+namespace
+{
+long liveHouses = 0;
+
+template<typename Link>
+struct House
+{
+    House() { ++liveHouses; }
+    ~House() { --liveHouses; }
+    Link neighbour;
+    int number = 0;
+};
+
+template<typename Link>
+struct TreeNode
+{
+    Link left;
+    Link right;
+};
+
+struct UniqueChainHouse : House<std::unique_ptr<UniqueChainHouse>> {};
+struct LinkChainHouse : House<util::LinkPtr<LinkChainHouse>> {};
+struct ArenaChainHouse : House<util::LinkPtr<ArenaChainHouse, util::ArenaDeleter<ArenaChainHouse>>> {};
+
+struct UniqueTreeNode : TreeNode<std::unique_ptr<UniqueTreeNode>> {};
+struct LinkTreeNode : TreeNode<util::LinkPtr<LinkTreeNode>> {};
+
+template<typename Pointer, typename Make>
+Pointer chain(std::size_t length, Make make)
+{
+    Pointer head;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        Pointer house = make();
+        house->neighbour = std::move(head);
+        head = std::move(house);
+    }
+    return head;
+}
+
+template<typename Pointer>
+Pointer tree(std::size_t count)
+{
+    if (count == 0)
+    {
+        return nullptr;
+    }
+    Pointer node(new typename Pointer::element_type);
+    node->left = tree<Pointer>((count - 1) / 2);
+    node->right = tree<Pointer>(count - 1 - (count - 1) / 2);
+    return node;
+}
+
+template<typename Pointer>
+double destroy(Pointer& root, std::size_t count)
+{
+    return bench::measure(1, [&root](std::size_t)
+    {
+        root = nullptr;
+    }) / count;
+}
+
+void chains(std::size_t size)
+{
+    std::size_t const shortLength = 100000;
+    auto uniqueChain = chain<std::unique_ptr<UniqueChainHouse>>(shortLength, [] { return std::make_unique<UniqueChainHouse>(); });
+    bench::report("chain of 100000, std::unique_ptr (recursive)", destroy(uniqueChain, shortLength));
+    auto linkChain = chain<util::LinkPtr<LinkChainHouse>>(shortLength, [] { return util::makeLink<LinkChainHouse>(); });
+    bench::report("chain of 100000, LinkPtr (loop)", destroy(linkChain, shortLength));
+
+    std::size_t const length = 10 * size;
+    std::string const prefix = "chain of " + std::to_string(length) + ", ";
+    linkChain = chain<util::LinkPtr<LinkChainHouse>>(length, [] { return util::makeLink<LinkChainHouse>(); });
+    bench::report(prefix + "LinkPtr (loop)", destroy(linkChain, length));
+    bench::report(prefix + "LinkPtr, houses left", static_cast<double>(liveHouses), "houses");
+
+    util::Arena arena(1 << 20);
+    auto arenaChain = chain<util::LinkPtr<ArenaChainHouse, util::ArenaDeleter<ArenaChainHouse>>>(length, [&arena]
+    {
+        return util::makeArenaLink<ArenaChainHouse>(arena);
+    });
+    bench::report(prefix + "Arena, node by node", destroy(arenaChain, length));
+    bench::report(prefix + "Arena, houses left", static_cast<double>(liveHouses), "houses");
+    arenaChain = chain<util::LinkPtr<ArenaChainHouse, util::ArenaDeleter<ArenaChainHouse>>>(length, [&arena]
+    {
+        return util::makeArenaLink<ArenaChainHouse>(arena);
+    });
+    //The houses own nothing outside of the arena: no destructor to run
+    bench::report(prefix + "Arena, release + reset", bench::measure(1, [&](std::size_t)
+    {
+        arenaChain.release();
+        arena.reset();
+    }) / length);
+    liveHouses = 0;
+}
+
+void trees(std::size_t size)
+{
+    std::string const prefix = "balanced tree of " + std::to_string(size) + ", ";
+    auto uniqueTree = tree<std::unique_ptr<UniqueTreeNode>>(size);
+    bench::report(prefix + "std::unique_ptr (recursive)", destroy(uniqueTree, size));
+    auto linkTree = tree<util::LinkPtr<LinkTreeNode>>(size);
+    bench::report(prefix + "LinkPtr (loop)", destroy(linkTree, size));
+}
+
+void run(std::size_t size)
+{
+    chains(size);
+    trees(size);
+}
+
+bench::Registration registration("LinkPtr vs recursive unique_ptr destruction", run);
+}
@@ -0,0 +1,172 @@
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "MappedImage.h"
+
+/*Startup with a graph of size nodes (1M by default) as in main.cpp: shared_ptrs to the children and
+weak_ptr back-edges to the parent, 4 children per node. The usual way rebuilds it from a file of
+flat records, one make_shared per node; an image is mapped and used as is. The file was just
+written, so it is in the page cache either way: this is the cost of the reconstruction, not of
+the disk. Mapping is lazy, so the first traversal of the image, which faults its pages in, is
+reported too. The round trip is checked on two mappings of the image, at two different addresses:
+any node whose value, children or back-edge doesn't match the original is a mismatch.*/
+
+namespace
+{
+struct Tree
+{
+    std::int64_t value = 0;
+    std::weak_ptr<Tree> parent;
+    std::vector<std::shared_ptr<Tree>> children;
+};
+
+struct Node
+{
+    explicit Node(std::int64_t value) : value(value) {}
+    std::int64_t value;
+    util::OffsetPtr<Node> parent;
+    util::OffsetArray<util::OffsetPtr<Node>> children;
+};
+
+//What the usual file holds: the nodes in breadth-first order, each with the index of its parent
+struct Record
+{
+    std::int64_t value;
+    std::int64_t parent;
+};
+
+std::size_t const fanOut = 4;
+
+std::shared_ptr<Tree> build(std::vector<Record> const& records)
+{
+    std::vector<std::shared_ptr<Tree>> nodes;
+    nodes.reserve(records.size());
+    for (Record const& record : records)
+    {
+        nodes.push_back(std::make_shared<Tree>());
+        nodes.back()->value = record.value;
+        if (record.parent >= 0)
+        {
+            nodes.back()->parent = nodes[record.parent];
+            nodes[record.parent]->children.push_back(nodes.back());
+        }
+    }
+    return nodes.empty() ? nullptr : nodes.front();
+}
+
+Node* persist(util::ImageWriter& writer, Tree const& tree)
+{
+    if (Node* copy = writer.find<Node>(&tree))
+    {
+        return copy;
+    }
+    Node* node = writer.create<Node>(tree.value);
+    writer.remember(&tree, node);
+    if (auto parent = tree.parent.lock())
+    {
+        node->parent = writer.find<Node>(parent.get());
+    }
+    node->children = writer.createArray<util::OffsetPtr<Node>>(tree.children.size());
+    for (std::size_t i = 0; i < tree.children.size(); ++i)
+    {
+        node->children[i] = persist(writer, *tree.children[i]);
+    }
+    return node;
+}
+
+std::size_t mismatches(Tree const& tree, Node const& node, Node const* parent)
+{
+    std::size_t count = tree.value != node.value || tree.children.size() != node.children.size() || node.parent.get() != parent;
+    for (std::size_t i = 0; i < tree.children.size() && i < node.children.size(); ++i)
+    {
+        count += mismatches(*tree.children[i], *node.children[i], &node);
+    }
+    return count;
+}
+
+std::int64_t sum(Tree const& tree)
+{
+    std::int64_t total = tree.value;
+    for (auto const& child : tree.children)
+    {
+        total += sum(*child);
+    }
+    return total;
+}
+
+std::int64_t sum(Node const& node)
+{
+    std::int64_t total = node.value;
+    for (auto const& child : node.children)
+    {
+        total += sum(*child);
+    }
+    return total;
+}
+
+void run(std::size_t size)
+{
+    std::string const recordsPath = "MappedImageBench.records";
+    std::string const imagePath = "MappedImageBench.image";
+    std::vector<Record> records(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        records[i] = {static_cast<std::int64_t>(i * 7 % 1000), i == 0 ? -1 : static_cast<std::int64_t>((i - 1) / fanOut)};
+    }
+    std::FILE* file = std::fopen(recordsPath.c_str(), "wb");
+    std::fwrite(records.data(), sizeof(Record), records.size(), file);
+    std::fclose(file);
+
+    //Startup by reconstruction
+    std::shared_ptr<Tree> tree;
+    bench::report("records: read + rebuild", bench::measure(1, [&](std::size_t)
+    {
+        std::vector<Record> loaded(size);
+        std::FILE* file = std::fopen(recordsPath.c_str(), "rb");
+        loaded.resize(std::fread(loaded.data(), sizeof(Record), size, file));
+        std::fclose(file);
+        tree = build(loaded);
+    }) / 1e6, "ms");
+    std::int64_t expected = 0;
+    bench::report("records: first traversal", bench::measure(1, [&](std::size_t)
+    {
+        expected = sum(*tree);
+    }) / 1e6, "ms");
+
+    //Writing the image, once at build time rather than at startup
+    bench::report("image: persist + save", bench::measure(1, [&](std::size_t)
+    {
+        util::ImageWriter writer;
+        writer.save(imagePath, persist(writer, *tree));
+    }) / 1e6, "ms");
+
+    //Startup by mapping
+    std::unique_ptr<util::MappedImage> image;
+    Node* root = nullptr;
+    bench::report("image: map", bench::measure(1, [&](std::size_t)
+    {
+        image.reset(new util::MappedImage(imagePath));
+        root = image->root<Node>();
+    }) / 1e6, "ms");
+    std::int64_t total = 0;
+    bench::report("image: first traversal", bench::measure(1, [&](std::size_t)
+    {
+        total = sum(*root);
+    }) / 1e6, "ms");
+    bench::report("image: size", image->size() / 1e6, "MB");
+
+    util::MappedImage other(imagePath);
+    Node const* otherRoot = other.root<Node>();
+    bench::report("round trip: mismatches, first mapping", static_cast<double>(mismatches(*tree, *root, nullptr) + (total != expected)), "nodes");
+    bench::report("round trip: mismatches, second mapping", static_cast<double>(mismatches(*tree, *otherRoot, nullptr)), "nodes");
+
+    image.reset();
+    std::remove(recordsPath.c_str());
+    std::remove(imagePath.c_str());
+}
+
+bench::Registration registration("MappedImage vs rebuilding a shared_ptr graph", run);
+}
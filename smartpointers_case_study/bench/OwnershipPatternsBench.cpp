@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "Engine.h"
+#include "LegacyFridge.h"
+#include "UniquePointerSet.h"
+
+/*The idioms that main.cpp only shows in comments, written out and measured side by side, in the
+order of main.cpp. The other benchmarks measure the replacements from include/ against them.*/
+
+namespace
+{
+struct Computer
+{
+    int cores = 8;
+    long memory = 16;
+};
+
+//Objects allocated on Stack vs Heap
+void stackVersusHeap(std::size_t size)
+{
+    bench::report("stack object", bench::measure(size, [](std::size_t)
+    {
+        Computer computer;
+        bench::doNotOptimize(computer);
+    }));
+    bench::report("raw new/delete", bench::measure(size, [](std::size_t)
+    {
+        Computer* computer = new Computer;
+        bench::doNotOptimize(computer);
+        delete computer;
+    }));
+    bench::report("std::make_unique", bench::measure(size, [](std::size_t)
+    {
+        auto computer = std::make_unique<Computer>();
+        bench::doNotOptimize(computer);
+    }));
+}
+
+//std::shared_ptr: one allocation for the object and the control block, or two
+void sharedPointers(std::size_t size)
+{
+    bench::report("std::make_shared", bench::measure(size, [](std::size_t)
+    {
+        auto computer = std::make_shared<Computer>();
+        bench::doNotOptimize(computer);
+    }));
+    bench::report("std::shared_ptr(new)", bench::measure(size, [](std::size_t)
+    {
+        std::shared_ptr<Computer> computer(new Computer);
+        bench::doNotOptimize(computer);
+    }));
+    auto const computer = std::make_shared<Computer>();
+    bench::report("shared_ptr copy (count increment and decrement)", bench::measure(size, [&computer](std::size_t)
+    {
+        std::shared_ptr<Computer> copy = computer;
+        bench::doNotOptimize(copy);
+    }));
+    std::weak_ptr<Computer> const weak = computer;
+    bench::report("weak_ptr::lock, object alive", bench::measure(size, [&weak](std::size_t)
+    {
+        bench::doNotOptimize(weak.lock());
+    }));
+    std::weak_ptr<Computer> const expired = std::make_shared<Computer>();
+    bench::report("weak_ptr::lock, object expired", bench::measure(size, [&expired](std::size_t)
+    {
+        bench::doNotOptimize(expired.lock());
+    }));
+}
+
+//The Fridge of main.cpp before the pimpl: Engine.h is included by every client
+class InlineFridge
+{
+    public:
+        void coolDown() { bench::doNotOptimize(engine_); }
+    private:
+        Engine engine_;
+};
+
+void pimplVersusInline(std::size_t size)
+{
+    bench::report("construct/destroy Fridge without pimpl", bench::measure(size, [](std::size_t)
+    {
+        InlineFridge fridge;
+        bench::doNotOptimize(fridge);
+    }));
+    bench::report("construct/destroy unique_ptr pimpl Fridge", bench::measure(size, [](std::size_t)
+    {
+        LegacyFridge fridge;
+        bench::doNotOptimize(fridge);
+    }));
+    std::vector<InlineFridge> inlineFridges(size);
+    bench::report("coolDown Fridge without pimpl", bench::measure(size, [&inlineFridges](std::size_t i)
+    {
+        inlineFridges[i].coolDown();
+    }));
+    std::vector<LegacyFridge> pimplFridges(size);
+    bench::report("coolDown unique_ptr pimpl Fridge", bench::measure(size, [&pimplFridges](std::size_t i)
+    {
+        pimplFridges[i].coolDown();
+    }));
+}
+
+class Base
+{
+    public:
+        explicit Base(int id) : id_(id) {}
+        virtual ~Base() = default;
+        virtual std::unique_ptr<Base> cloneBase() const = 0;
+        //The covariant version: a raw pointer, that the caller has to wrap
+        virtual Base* clone() const = 0;
+        int id() const { return id_; }
+    private:
+        int id_;
+};
+
+class Derived : public Base
+{
+    public:
+        using Base::Base;
+        std::unique_ptr<Base> cloneBase() const override
+        {
+            return std::make_unique<Derived>(*this);
+        }
+        Derived* clone() const override
+        {
+            return new Derived(*this);
+        }
+};
+
+bool operator<(Base const& b1, Base const& b2) { return b1.id() < b2.id(); }
+
+//Half of the ids of source are already in destination, like in TransferUniqueBench.cpp
+template<typename Container>
+void fill(Container& container, std::size_t size, int step)
+{
+    std::vector<int> ids;
+    for (std::size_t id = 0; id < size; id += step)
+    {
+        ids.push_back(static_cast<int>(id));
+    }
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(7));
+    for (int id : ids)
+    {
+        container.insert(container.end(), std::make_unique<Derived>(id));
+    }
+}
+
+//How to Transfer unique_ptr from a set to another set
+void setTransfer(std::size_t size)
+{
+    {
+        util::UniquePointerSet<Base> destination;
+        util::UniquePointerSet<Base> source;
+        fill(destination, size, 2);
+        fill(source, size, 1);
+        auto clone = [](std::unique_ptr<Base> const& pointer){ return pointer->cloneBase(); };
+        bench::report("set -> set, clone with std::transform", bench::measure(1, [&](std::size_t)
+        {
+            std::transform(begin(source), end(source), std::inserter(destination, end(destination)), clone);
+            source.clear();
+        }) / size);
+    }
+    {
+        util::UniquePointerSet<Base> destination;
+        std::vector<std::unique_ptr<Base>> source;
+        fill(destination, size, 2);
+        fill(source, size, 1);
+        bench::report("vector -> set, std::move", bench::measure(1, [&](std::size_t)
+        {
+            std::move(begin(source), end(source), std::inserter(destination, end(destination)));
+            source.clear();
+        }) / size);
+    }
+#if __cplusplus >= 201703L
+    {
+        util::UniquePointerSet<Base> destination;
+        util::UniquePointerSet<Base> source;
+        fill(destination, size, 2);
+        fill(source, size, 1);
+        bench::report("set -> set, merge", bench::measure(1, [&](std::size_t)
+        {
+            destination.merge(source);
+        }) / size);
+    }
+#endif
+}
+
+//Seeing the real face of std::unique_ptr: what the deleter costs in size and in time
+void deleteComputer(Computer* computer)
+{
+    delete computer;
+}
+
+struct ComputerDeleter
+{
+    void operator()(Computer* computer) const { delete computer; }
+};
+
+template<typename Pointer, typename Make>
+void createDestroy(std::string const& name, std::size_t size, Make make)
+{
+    bench::report(name + " bytes", sizeof(Pointer), "B");
+    std::vector<Pointer> pointers;
+    pointers.reserve(size);
+    bench::report(name + " create/destroy", bench::measure(size, [&](std::size_t)
+    {
+        pointers.push_back(make());
+    }) + bench::measure(1, [&pointers](std::size_t)
+    {
+        pointers.clear();
+    }) / size);
+}
+
+void deleters(std::size_t size)
+{
+    using FunctionPointerPtr = std::unique_ptr<Computer, void(*)(Computer*)>;
+    using FunctionObjectPtr = std::unique_ptr<Computer, ComputerDeleter>;
+    using StdFunctionPtr = std::unique_ptr<Computer, std::function<void(Computer*)>>;
+    createDestroy<std::unique_ptr<Computer>>("std::default_delete", size,
+        [] { return std::make_unique<Computer>(); });
+    createDestroy<FunctionObjectPtr>("stateless function object", size,
+        [] { return FunctionObjectPtr(new Computer); });
+    createDestroy<FunctionPointerPtr>("function pointer", size,
+        [] { return FunctionPointerPtr(new Computer, deleteComputer); });
+    createDestroy<StdFunctionPtr>("std::function", size,
+        [] { return StdFunctionPtr(new Computer, deleteComputer); });
+}
+
+//How to Return a Smart Pointer AND Use Covariance
+void covariance(std::size_t size)
+{
+    std::unique_ptr<Base> const original = std::make_unique<Derived>(1);
+    bench::report("clone, covariant raw pointer wrapped by the caller", bench::measure(size, [&original](std::size_t)
+    {
+        std::unique_ptr<Base> copy(original->clone());
+        bench::doNotOptimize(copy);
+    }));
+    bench::report("cloneBase, unique_ptr<Base>", bench::measure(size, [&original](std::size_t)
+    {
+        std::unique_ptr<Base> copy = original->cloneBase();
+        bench::doNotOptimize(copy);
+    }));
+}
+
+void run(std::size_t size)
+{
+    stackVersusHeap(size);
+    sharedPointers(size);
+    pimplVersusInline(size);
+    setTransfer(size);
+    deleters(size);
+    covariance(size);
+}
+
+bench::Registration registration("main.cpp ownership patterns", run);
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Benchmark.h"
+#include "PolymorphicCollection.h"
+
+namespace
+{
+class Base
+{
+    public:
+        virtual ~Base() = default;
+        virtual void update() = 0;
+        virtual long value() const = 0;
+};
+
+class Particle final : public Base
+{
+    public:
+        void update() override { position_ += speed_; }
+        long value() const override { return position_; }
+    private:
+        long position_ = 0;
+        long speed_ = 1;
+};
+
+class Emitter final : public Base
+{
+    public:
+        void update() override { ++emitted_; rate_ = emitted_ % 7; }
+        long value() const override { return emitted_ + rate_; }
+    private:
+        long emitted_ = 0;
+        long rate_ = 0;
+        double direction_[4] = {};
+};
+
+class Attractor final : public Base
+{
+    public:
+        void update() override { mass_ *= 2; mass_ %= 1021; }
+        long value() const override { return mass_; }
+    private:
+        long mass_ = 3;
+        double field_[2] = {};
+};
+
+void run(std::size_t size)
+{
+    std::mt19937 random(42);
+    std::vector<std::unique_ptr<Base>> pointers;
+    util::PolymorphicCollection<Base> collection;
+    pointers.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        switch (random() % 3)
+        {
+            case 0:
+                pointers.push_back(std::make_unique<Particle>());
+                collection.emplace<Particle>();
+                break;
+            case 1:
+                pointers.push_back(std::make_unique<Emitter>());
+                collection.emplace<Emitter>();
+                break;
+            default:
+                pointers.push_back(std::make_unique<Attractor>());
+                collection.emplace<Attractor>();
+                break;
+        }
+    }
+    //A long-running program doesn't find its objects in allocation order
+    std::shuffle(pointers.begin(), pointers.end(), random);
+
+    long sum = 0;
+    bench::report("vector<unique_ptr<Base>> virtual update", bench::measure(1, [&](std::size_t)
+    {
+        for (auto const& pointer : pointers)
+        {
+            pointer->update();
+            sum += pointer->value();
+        }
+    }) / size);
+    bench::report("PolymorphicCollection virtual update", bench::measure(1, [&](std::size_t)
+    {
+        collection.forEach([&](Base& object)
+        {
+            object.update();
+            sum += object.value();
+        });
+    }) / size);
+    bench::report("PolymorphicCollection per-type update", bench::measure(1, [&](std::size_t)
+    {
+        auto const update = [&](auto& object)
+        {
+            object.update();
+            sum += object.value();
+        };
+        collection.forEach<Particle>(update);
+        collection.forEach<Emitter>(update);
+        collection.forEach<Attractor>(update);
+    }) / size);
+    bench::doNotOptimize(sum);
+}
+
+bench::Registration registration("PolymorphicCollection vs vector<unique_ptr>", run);
+}
@@ -0,0 +1,90 @@
+#include <memory>
+#include <vector>
+#include "Benchmark.h"
+#include "PolymorphicValue.h"
+
+namespace
+{
+class Instructions
+{
+    public:
+        virtual ~Instructions() = default;
+        virtual std::unique_ptr<Instructions> cloneBase() const = 0;
+        virtual int steps() const = 0;
+};
+
+class Sketch : public Instructions
+{
+    public:
+        std::unique_ptr<Instructions> cloneBase() const override { return std::make_unique<Sketch>(*this); }
+        int steps() const override { return strokes_; }
+    private:
+        int strokes_ = 1;
+};
+
+class Blueprint : public Instructions
+{
+    public:
+        std::unique_ptr<Instructions> cloneBase() const override { return std::make_unique<Blueprint>(*this); }
+        int steps() const override { return pages_ * 2; }
+    private:
+        int pages_ = 5;
+        double scale_ = 1.0;
+};
+
+void run(std::size_t size)
+{
+    std::vector<std::unique_ptr<Instructions>> pointers;
+    std::vector<util::PolymorphicValue<Instructions>> values;
+    pointers.reserve(size);
+    values.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (i % 2)
+        {
+            pointers.push_back(std::make_unique<Sketch>());
+            values.push_back(util::makePolymorphic<Instructions, Sketch>());
+        }
+        else
+        {
+            pointers.push_back(std::make_unique<Blueprint>());
+            values.push_back(util::makePolymorphic<Instructions, Blueprint>());
+        }
+    }
+
+    bench::report("copy vector<unique_ptr> with cloneBase loop", bench::measure(1, [&](std::size_t)
+    {
+        std::vector<std::unique_ptr<Instructions>> copy;
+        copy.reserve(pointers.size());
+        for (auto const& pointer : pointers)
+        {
+            copy.push_back(pointer->cloneBase());
+        }
+        bench::doNotOptimize(copy);
+    }) / size);
+    bench::report("copy vector<PolymorphicValue>", bench::measure(1, [&](std::size_t)
+    {
+        std::vector<util::PolymorphicValue<Instructions>> copy = values;
+        bench::doNotOptimize(copy);
+    }) / size);
+
+    long steps = 0;
+    bench::report("iterate vector<unique_ptr>", bench::measure(1, [&](std::size_t)
+    {
+        for (auto const& pointer : pointers)
+        {
+            steps += pointer->steps();
+        }
+    }) / size);
+    bench::report("iterate vector<PolymorphicValue>", bench::measure(1, [&](std::size_t)
+    {
+        for (auto const& value : values)
+        {
+            steps += value->steps();
+        }
+    }) / size);
+    bench::doNotOptimize(steps);
+}
+
+bench::Registration registration("PolymorphicValue vs cloneBase", run);
+}
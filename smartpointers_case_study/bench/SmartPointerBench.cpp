@@ -0,0 +1,122 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "SmartPointer.h"
+
+/*Each SmartPointer policy against its std equivalent: creation and destruction of size pointers,
+copy and destruction for the counted ones, and a pass that dereferences size pointers, where the
+checking policy adds its test. The layouts are checked at compile time by the static_asserts of
+SmartPointer.h, the sizes are printed here for reference.*/
+
+namespace
+{
+struct Widget
+{
+    explicit Widget(int value) : value(value) {}
+    int value;
+};
+
+using Scoped = util::SmartPointer<Widget, util::ScopedOwnership>;
+using Unique = util::SmartPointer<Widget>;
+using UniqueThrowing = util::SmartPointer<Widget, util::UniqueOwnership, util::ThrowChecking>;
+using Counted = util::SmartPointer<Widget, util::CountedOwnership<util::SingleThreaded>>;
+using Borrowed = util::SmartPointer<Widget, util::BorrowedOwnership>;
+
+template<typename Make>
+double createAndDestroy(std::size_t size, Make make)
+{
+    return bench::measure(size, [&make](std::size_t i)
+    {
+        auto pointer = make(static_cast<int>(i));
+        bench::doNotOptimize(pointer);
+    });
+}
+
+template<typename Pointer>
+double copyAndDestroy(std::size_t size, Pointer const& original)
+{
+    return bench::measure(size, [&original](std::size_t)
+    {
+        Pointer copy = original;
+        bench::doNotOptimize(copy);
+    });
+}
+
+template<typename Pointer, typename Make>
+double dereference(std::size_t size, Make make)
+{
+    std::vector<Pointer> pointers;
+    pointers.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        pointers.push_back(make(static_cast<int>(i)));
+    }
+    long sum = 0;
+    double const nanoseconds = bench::measure(1, [&](std::size_t)
+    {
+        for (auto const& pointer : pointers)
+        {
+            sum += pointer->value;
+        }
+    }) / size;
+    bench::doNotOptimize(sum);
+    return nanoseconds;
+}
+
+void creation(std::size_t size)
+{
+    bench::report("scoped: SmartPointer", createAndDestroy(size, [](int i)
+    {
+        Scoped pointer(new Widget(i));
+        bench::doNotOptimize(pointer);
+        return pointer->value;
+    }));
+    bench::report("unique: std::unique_ptr", createAndDestroy(size, [](int i) { return std::make_unique<Widget>(i); }));
+    bench::report("unique: SmartPointer", createAndDestroy(size, [](int i) { return util::makeSmart<Widget>(i); }));
+    bench::report("counted: std::shared_ptr(new)", createAndDestroy(size, [](int i) { return std::shared_ptr<Widget>(new Widget(i)); }));
+    bench::report("counted: std::make_shared", createAndDestroy(size, [](int i) { return std::make_shared<Widget>(i); }));
+    bench::report("counted: SmartPointer, single-threaded", createAndDestroy(size, [](int i)
+    {
+        return util::makeSmart<Widget, util::CountedOwnership<util::SingleThreaded>>(i);
+    }));
+    bench::report("counted: SmartPointer, atomic", createAndDestroy(size, [](int i)
+    {
+        return util::makeSmart<Widget, util::CountedOwnership<util::MultiThreaded>>(i);
+    }));
+}
+
+void copies(std::size_t size)
+{
+    auto const shared = std::make_shared<Widget>(1);
+    bench::report("copy: std::shared_ptr", copyAndDestroy(size, shared));
+    bench::report("copy: SmartPointer, single-threaded", copyAndDestroy(size, util::makeSmart<Widget, util::CountedOwnership<util::SingleThreaded>>(1)));
+    bench::report("copy: SmartPointer, atomic", copyAndDestroy(size, util::makeSmart<Widget, util::CountedOwnership<util::MultiThreaded>>(1)));
+    Widget widget(1);
+    Widget* const raw = &widget;
+    bench::report("copy: raw pointer", copyAndDestroy(size, raw));
+    bench::report("copy: SmartPointer, borrowed", copyAndDestroy(size, Borrowed(&widget)));
+}
+
+void dereferences(std::size_t size)
+{
+    bench::report("dereference: std::unique_ptr", dereference<std::unique_ptr<Widget>>(size, [](int i) { return std::make_unique<Widget>(i); }));
+    bench::report("dereference: SmartPointer, NoChecking", dereference<Unique>(size, [](int i) { return util::makeSmart<Widget>(i); }));
+    bench::report("dereference: SmartPointer, ThrowChecking", dereference<UniqueThrowing>(size, [](int i)
+    {
+        return util::makeSmart<Widget, util::UniqueOwnership, util::ThrowChecking>(i);
+    }));
+}
+
+void run(std::size_t size)
+{
+    creation(size);
+    copies(size);
+    dereferences(size);
+    bench::report("sizeof: unique, scoped, borrowed", static_cast<double>(sizeof(Unique)), "bytes");
+    bench::report("sizeof: counted, single-threaded or atomic", static_cast<double>(sizeof(Counted)), "bytes");
+    bench::report("sizeof: std::shared_ptr", static_cast<double>(sizeof(std::shared_ptr<Widget>)), "bytes");
+}
+
+bench::Registration registration("SmartPointer policies vs std smart pointers", run);
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "TransferUnique.h"
+
+namespace
+{
+class Base
+{
+    public:
+        explicit Base(int id) : id_(id) {}
+        virtual ~Base() = default;
+        virtual std::unique_ptr<Base> cloneBase() const = 0;
+        int id() const { return id_; }
+    private:
+        int id_;
+};
+
+class Derived : public Base
+{
+    public:
+        using Base::Base;
+        std::unique_ptr<Base> cloneBase() const override
+        {
+            return std::make_unique<Derived>(*this);
+        }
+};
+
+bool operator<(Base const& b1, Base const& b2) { return b1.id() < b2.id(); }
+
+//Even ids in destination, all ids in source: half of source are duplicates
+template<typename Container>
+void fill(Container& container, std::size_t size, int step)
+{
+    std::vector<std::unique_ptr<Base>> elements;
+    for (std::size_t id = 0; id < size; id += step)
+    {
+        elements.push_back(std::make_unique<Derived>(static_cast<int>(id)));
+    }
+    std::shuffle(elements.begin(), elements.end(), std::mt19937(7));
+    util::transferUnique(container, elements);
+}
+
+template<typename Destination, typename Source>
+void transfer(char const* name, std::size_t size)
+{
+    Destination destination;
+    Source source;
+    fill(destination, size, 2);
+    fill(source, size, 1);
+    bench::report(std::string("transferUnique ") + name, bench::measure(1, [&](std::size_t)
+    {
+        util::transferUnique(destination, source);
+    }) / size);
+}
+
+//The pre-C++17 fallback of main.cpp
+void cloneTransfer(std::size_t size)
+{
+    util::UniquePointerSet<Base> destination;
+    util::UniquePointerSet<Base> source;
+    fill(destination, size, 2);
+    fill(source, size, 1);
+    auto clone = [](std::unique_ptr<Base> const& pointer){ return pointer->cloneBase(); };
+    bench::report("std::transform with cloneBase set -> set", bench::measure(1, [&](std::size_t)
+    {
+        std::transform(begin(source), end(source), std::inserter(destination, end(destination)), clone);
+        source.clear();
+    }) / size);
+}
+
+void run(std::size_t size)
+{
+    cloneTransfer(size);
+    transfer<util::UniquePointerSet<Base>, util::UniquePointerSet<Base>>("set -> set", size);
+    transfer<util::UniquePointerSet<Base>, std::vector<std::unique_ptr<Base>>>("vector -> set", size);
+    transfer<util::FlatUniquePointerSet<Base>, util::FlatUniquePointerSet<Base>>("flat set -> flat set", size);
+    transfer<util::FlatUniquePointerSet<Base>, util::UniquePointerSet<Base>>("set -> flat set", size);
+    transfer<std::vector<std::unique_ptr<Base>>, util::UniquePointerSet<Base>>("set -> vector", size);
+}
+
+bench::Registration registration("transferUnique vs cloneBase", run);
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "Benchmark.h"
+#include "UniquePointerSet.h"
+
+namespace
+{
+class Base
+{
+    public:
+        explicit Base(int id) : id_(id) {}
+        virtual ~Base() = default;
+        int id() const { return id_; }
+    private:
+        int id_;
+};
+
+class Derived : public Base
+{
+    public:
+        using Base::Base;
+};
+
+bool operator<(Base const& b1, Base const& b2) { return b1.id() < b2.id(); }
+bool operator<(Base const& b, int id) { return b.id() < id; }
+bool operator<(int id, Base const& b) { return id < b.id(); }
+
+struct IdOf
+{
+    int operator()(Base const& b) const { return b.id(); }
+};
+
+std::vector<int> shuffledIds(std::size_t size, unsigned seed)
+{
+    std::vector<int> ids(size);
+    std::iota(ids.begin(), ids.end(), 0);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(seed));
+    return ids;
+}
+
+std::vector<std::unique_ptr<Base>> makeElements(std::vector<int> const& ids)
+{
+    std::vector<std::unique_ptr<Base>> elements;
+    elements.reserve(ids.size());
+    for (int id : ids)
+    {
+        elements.push_back(std::make_unique<Derived>(id));
+    }
+    return elements;
+}
+
+template<typename Set>
+void measureSet(char const* name, Set& set, std::vector<int> const& lookups)
+{
+    std::string const prefix(name);
+    bench::report(prefix + " find by key", bench::measure(lookups.size(), [&](std::size_t i)
+    {
+        bench::doNotOptimize(set.find(lookups[i]));
+    }));
+    long sum = 0;
+    bench::report(prefix + " iterate", bench::measure(1, [&](std::size_t)
+    {
+        for (auto const& pointer : set)
+        {
+            sum += pointer->id();
+        }
+    }) / set.size());
+    bench::doNotOptimize(sum);
+}
+
+void run(std::size_t size)
+{
+    auto const ids = shuffledIds(size, 1);
+    auto const lookups = shuffledIds(size, 2);
+
+    util::UniquePointerSet<Base> set;
+    auto elements = makeElements(ids);
+    bench::report("std::set insert one by one", bench::measure(size, [&](std::size_t i)
+    {
+        set.insert(std::move(elements[i]));
+    }));
+    measureSet("std::set", set, lookups);
+
+    util::FlatUniquePointerSet<Base> flat;
+    elements = makeElements(ids);
+    bench::report("flat set bulk insert", bench::measure(1, [&](std::size_t)
+    {
+        flat.insert(std::move(elements));
+    }) / size);
+    measureSet("flat set", flat, lookups);
+
+    util::FlatUniquePointerSet<Base, IdOf> keyed;
+    elements = makeElements(ids);
+    bench::report("flat set with cached key bulk insert", bench::measure(1, [&](std::size_t)
+    {
+        keyed.insert(std::move(elements));
+    }) / size);
+    measureSet("flat set with cached key", keyed, lookups);
+}
+
+bench::Registration registration("UniquePointerSet vs FlatUniquePointerSet", run);
+}
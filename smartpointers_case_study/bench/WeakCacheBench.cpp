@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Benchmark.h"
+#include "WeakCache.h"
+
+namespace
+{
+struct Resource
+{
+    explicit Resource(int id) : id(id) {}
+    int id;
+    char payload[64] = {};
+};
+
+using Cache = util::WeakCache<int, Resource>;
+
+/*Every reader looks up ids with a skewed distribution (a few hot ids, a long tail), and builds the
+Resource on a miss. Nothing outside of the cache holds the Resources, so what stays alive between
+two lookups is what the retention tier keeps.*/
+void readers(char const* name, std::size_t retainedCapacity, unsigned threadCount, std::size_t lookups)
+{
+    int const idCount = 100000;
+    Cache cache(retainedCapacity);
+    std::atomic<std::size_t> hits{0};
+    std::vector<std::vector<double>> latencies(threadCount);
+    std::vector<std::thread> threads;
+    auto const start = bench::Clock::now();
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            std::mt19937 random(t);
+            std::exponential_distribution<double> skew(8.0);
+            std::size_t localHits = 0;
+            auto& latency = latencies[t];
+            latency.reserve(lookups);
+            for (std::size_t i = 0; i < lookups; ++i)
+            {
+                int const id = static_cast<int>(std::min(skew(random), 1.0) * (idCount - 1));
+                auto const before = bench::Clock::now();
+                auto resource = cache.find(id);
+                if (resource)
+                {
+                    ++localHits;
+                }
+                else
+                {
+                    resource = cache.findOrCreate(id, [id] { return std::make_shared<Resource>(id); });
+                }
+                latency.push_back(std::chrono::duration<double, std::nano>(bench::Clock::now() - before).count());
+                bench::doNotOptimize(resource);
+            }
+            hits += localHits;
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    double const seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto const& latency : latencies)
+    {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) { return all[static_cast<std::size_t>(p * (all.size() - 1))]; };
+
+    std::string const prefix = std::string(name) + ", " + std::to_string(threadCount) + " threads, ";
+    bench::report(prefix + "hit rate", 100.0 * hits / (threadCount * lookups), "%");
+    bench::report(prefix + "p50", percentile(0.50));
+    bench::report(prefix + "p99", percentile(0.99));
+    bench::report(prefix + "p99.9", percentile(0.999));
+    bench::report(prefix + "throughput", threadCount * lookups / seconds / 1e6, "M lookups/s");
+}
+
+void run(std::size_t size)
+{
+    for (unsigned threadCount = 1; threadCount <= 32; threadCount *= 2)
+    {
+        std::size_t const lookups = std::max<std::size_t>(size / threadCount, 1);
+        readers("weak only", 0, threadCount, lookups);
+        readers("retain 4096", 4096, threadCount, lookups);
+    }
+}
+
+bench::Registration registration("WeakCache concurrent lookups", run);
+}
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#ifdef __linux__
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench
+{
+namespace
+{
+struct Entry
+{
+    char const* name;
+    Function function;
+};
+
+std::vector<Entry>& registry()
+{
+    static std::vector<Entry> entries;
+    return entries;
+}
+
+//The samples of one reported line, in the order of the first report
+struct Line
+{
+    std::string name;
+    std::string unit;
+    std::vector<double> samples;
+};
+
+struct Statistics
+{
+    double median;
+    double mean;
+    double min;
+    double max;
+    double stddev;
+};
+
+//Lines of the benchmark that is running; null during warm-up, whose reports are dropped
+std::vector<Line>* currentLines = nullptr;
+
+Statistics statistics(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    std::size_t const n = samples.size();
+    Statistics s;
+    s.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    s.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+    s.min = samples.front();
+    s.max = samples.back();
+    double squares = 0;
+    for (double sample : samples)
+    {
+        squares += (sample - s.mean) * (sample - s.mean);
+    }
+    s.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+    return s;
+}
+
+void print(Line const& line)
+{
+    Statistics const s = statistics(line.samples);
+    std::cout << std::left << std::setw(56) << line.name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << s.median << " " << std::left << std::setw(12) << line.unit << std::right;
+    if (line.samples.size() > 1)
+    {
+        std::cout << " +-" << std::setw(5) << std::setprecision(1) << (s.mean != 0 ? 100 * s.stddev / std::fabs(s.mean) : 0)
+                  << "%   min " << std::setprecision(2) << s.min;
+    }
+    std::cout << std::endl;
+}
+
+std::string escaped(std::string const& text)
+{
+    std::string result;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+struct Group
+{
+    char const* benchmark;
+    std::vector<Line> lines;
+};
+
+void writeJson(std::ostream& out, std::vector<Group> const& groups, std::size_t size, unsigned warmups, unsigned repetitions)
+{
+    out << std::setprecision(6) << std::defaultfloat;
+    out << "{\n  \"size\": " << size << ",\n  \"warmups\": " << warmups << ",\n  \"repetitions\": " << repetitions
+        << ",\n  \"results\": [";
+    char const* separator = "\n";
+    for (Group const& group : groups)
+    {
+        for (Line const& line : group.lines)
+        {
+            Statistics const s = statistics(line.samples);
+            out << separator << "    {\"benchmark\": \"" << escaped(group.benchmark) << "\", \"name\": \"" << escaped(line.name)
+                << "\", \"unit\": \"" << escaped(line.unit) << "\", \"median\": " << s.median << ", \"mean\": " << s.mean
+                << ", \"min\": " << s.min << ", \"max\": " << s.max << ", \"stddev\": " << s.stddev << ", \"samples\": [";
+            for (std::size_t i = 0; i < line.samples.size(); ++i)
+            {
+                out << (i ? ", " : "") << line.samples[i];
+            }
+            out << "]}";
+            separator = ",\n";
+        }
+    }
+    out << "\n  ]\n}\n";
+}
+}
+
+Registration::Registration(char const* name, Function function)
+{
+    registry().push_back({name, function});
+}
+
+#ifdef __linux__
+CacheMissCounter::CacheMissCounter()
+{
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof attributes);
+    attributes.size = sizeof attributes;
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    descriptor_ = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+CacheMissCounter::~CacheMissCounter()
+{
+    if (available())
+    {
+        close(descriptor_);
+    }
+}
+
+void CacheMissCounter::start()
+{
+    if (available())
+    {
+        ioctl(descriptor_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(descriptor_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+double CacheMissCounter::stop()
+{
+    std::uint64_t misses = 0;
+    if (!available())
+    {
+        return -1;
+    }
+    ioctl(descriptor_, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(descriptor_, &misses, sizeof misses) != static_cast<ssize_t>(sizeof misses))
+    {
+        return -1;
+    }
+    return static_cast<double>(misses);
+}
+#else
+CacheMissCounter::CacheMissCounter() : descriptor_(-1) {}
+CacheMissCounter::~CacheMissCounter() = default;
+void CacheMissCounter::start() {}
+double CacheMissCounter::stop() { return -1; }
+#endif
+
+void report(std::string const& name, double value, char const* unit)
+{
+    if (!currentLines)
+    {
+        return;
+    }
+    auto line = std::find_if(currentLines->begin(), currentLines->end(), [&name](Line const& l) { return l.name == name; });
+    if (line == currentLines->end())
+    {
+        currentLines->push_back({name, unit, {}});
+        line = currentLines->end() - 1;
+    }
+    line->samples.push_back(value);
+}
+}
+
+//Usage: benchmark [--warmups=n] [--repetitions=n] [--json=file] [filter] [size]
+int main(int argc, char** argv)
+{
+    std::string filter;
+    std::size_t size = 1000000;
+    unsigned warmups = 1;
+    unsigned repetitions = 5;
+    std::string jsonPath;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string const argument = argv[i];
+        auto value = [&argument](char const* option) { return argument.substr(std::string(option).size()); };
+        if (argument.compare(0, 10, "--warmups=") == 0)
+        {
+            warmups = static_cast<unsigned>(std::strtoul(value("--warmups=").c_str(), nullptr, 10));
+        }
+        else if (argument.compare(0, 14, "--repetitions=") == 0)
+        {
+            repetitions = std::max(1u, static_cast<unsigned>(std::strtoul(value("--repetitions=").c_str(), nullptr, 10)));
+        }
+        else if (argument.compare(0, 7, "--json=") == 0)
+        {
+            jsonPath = value("--json=");
+        }
+        else
+        {
+            positional.push_back(argument);
+        }
+    }
+    if (positional.size() > 0)
+    {
+        filter = positional[0];
+    }
+    if (positional.size() > 1)
+    {
+        size = std::strtoull(positional[1].c_str(), nullptr, 10);
+    }
+
+    std::vector<bench::Group> groups;
+    for (auto const& entry : bench::registry())
+    {
+        if (std::string(entry.name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        std::cout << "== " << entry.name << std::endl;
+        groups.push_back({entry.name, {}});
+        for (unsigned i = 0; i < warmups; ++i)
+        {
+            entry.function(size);
+        }
+        bench::currentLines = &groups.back().lines;
+        for (unsigned i = 0; i < repetitions; ++i)
+        {
+            entry.function(size);
+        }
+        bench::currentLines = nullptr;
+        for (auto const& line : groups.back().lines)
+        {
+            bench::print(line);
+        }
+    }
+    if (!jsonPath.empty())
+    {
+        std::ofstream json(jsonPath);
+        bench::writeJson(json, groups, size, warmups, repetitions);
+    }
+    return 0;
+}
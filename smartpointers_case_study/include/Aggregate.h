@@ -0,0 +1,195 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/*An impl that owns its collaborators through unique_ptrs, like a FridgeImpl with an Engine, a
+Compressor and a Thermostat, costs one heap block per component, scattered wherever the allocator
+finds room. Every call that goes through the components follows a pointer to another block, most
+likely on another cache line.*/
+
+/*makeAggregate builds the owner and its components in a single allocation, the way
+std::make_shared puts the object next to its control block:
+auto impl = util::makeAggregate<FridgeImpl, ElectricEngine, Compressor, Thermostat>(args...);
+The components are default constructed first, in this order, at offsets known at compile time,
+then the owner is constructed with a reference to each of them, followed by args. The owner keeps
+them as Attached<T> members: a 32-bit offset from the member itself instead of a pointer, which
+only works because the components never move relative to the owner. Destroying the AggregatePtr
+destroys the owner, then the components in reverse order, and frees the block once.
+class FridgeImpl
+{
+    public:
+        FridgeImpl(Engine& engine, Compressor& compressor, Thermostat& thermostat)
+            : engine_(engine), compressor_(compressor), thermostat_(thermostat) {}
+    private:
+        util::Attached<Engine> engine_;
+        ...
+};*/
+
+namespace util
+{
+template<typename T>
+class Attached
+{
+    public:
+        explicit Attached(T& target) noexcept
+            : offset_(static_cast<std::int32_t>(reinterpret_cast<std::intptr_t>(&target) - reinterpret_cast<std::intptr_t>(this)))
+        {
+        }
+
+        //The offset is relative to where the Attached is: a copy elsewhere would point elsewhere
+        Attached(const Attached&) = delete;
+        Attached& operator=(const Attached&) = delete;
+
+        T* get() const noexcept
+        {
+            return reinterpret_cast<T*>(reinterpret_cast<std::intptr_t>(this) + offset_);
+        }
+
+        T& operator*() const noexcept { return *get(); }
+        T* operator->() const noexcept { return get(); }
+
+    private:
+        std::int32_t offset_;
+};
+
+//Owns the owner and its components; the deleter knows their types and offsets
+template<typename Owner>
+using AggregatePtr = std::unique_ptr<Owner, void(*)(Owner*)>;
+
+namespace detail
+{
+template<std::size_t Count>
+struct AggregateLayout
+{
+    std::size_t offsets[Count];
+    std::size_t size;
+};
+
+//The owner at offset 0, then each component at the next offset aligned for it
+template<typename... Parts>
+constexpr AggregateLayout<sizeof...(Parts)> aggregateLayout()
+{
+    std::size_t const sizes[] = {sizeof(Parts)...};
+    std::size_t const alignments[] = {alignof(Parts)...};
+    AggregateLayout<sizeof...(Parts)> layout{};
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < sizeof...(Parts); ++i)
+    {
+        offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+        layout.offsets[i] = offset;
+        offset += sizes[i];
+    }
+    layout.size = offset;
+    return layout;
+}
+
+template<typename T>
+void destroyAt(void* pointer) noexcept
+{
+    static_cast<T*>(pointer)->~T();
+}
+
+//Destroys the first constructed components in reverse order, and frees the block, unless released
+template<typename Owner, typename... Components>
+class AggregateBlock
+{
+    public:
+        static constexpr AggregateLayout<sizeof...(Components) + 1> layout = aggregateLayout<Owner, Components...>();
+
+        AggregateBlock() : memory_(static_cast<char*>(::operator new(layout.size))) {}
+        AggregateBlock(const AggregateBlock&) = delete;
+        AggregateBlock& operator=(const AggregateBlock&) = delete;
+
+        ~AggregateBlock()
+        {
+            if (!memory_)
+            {
+                return;
+            }
+            void (* const destroyers[])(void*) = {&destroyAt<Components>...};
+            while (constructed_ > 0)
+            {
+                --constructed_;
+                destroyers[constructed_](memory_ + layout.offsets[constructed_ + 1]);
+            }
+            ::operator delete(memory_);
+        }
+
+        template<std::size_t Index, typename Component>
+        Component& construct()
+        {
+            Component* component = new (memory_ + layout.offsets[Index + 1]) Component();
+            ++constructed_;
+            return *component;
+        }
+
+        template<typename... Args>
+        Owner* constructOwner(Args&&... args)
+        {
+            Owner* owner = new (memory_) Owner(std::forward<Args>(args)...);
+            memory_ = nullptr;
+            return owner;
+        }
+
+        template<std::size_t Index, typename Component>
+        static Component& component(Owner* owner) noexcept
+        {
+            return *reinterpret_cast<Component*>(reinterpret_cast<char*>(owner) + layout.offsets[Index + 1]);
+        }
+
+    private:
+        char* memory_;
+        std::size_t constructed_ = 0;
+};
+
+template<typename Owner, typename... Components>
+constexpr AggregateLayout<sizeof...(Components) + 1> AggregateBlock<Owner, Components...>::layout;
+
+template<typename Owner, typename... Components, std::size_t... Indices>
+void destroyAggregate(Owner* owner, std::index_sequence<Indices...>) noexcept
+{
+    using Block = AggregateBlock<Owner, Components...>;
+    owner->~Owner();
+    void* const components[] = {nullptr, &Block::template component<Indices, Components>(owner)...};
+    void (* const destroyers[])(void*) = {nullptr, &destroyAt<Components>...};
+    for (std::size_t i = sizeof...(Components); i > 0; --i)
+    {
+        destroyers[i](components[i]);
+    }
+    ::operator delete(owner);
+}
+
+template<typename Owner, typename... Components>
+void destroyAggregate(Owner* owner) noexcept
+{
+    destroyAggregate<Owner, Components...>(owner, std::index_sequence_for<Components...>());
+}
+
+template<typename Owner, typename... Components, std::size_t... Indices, typename... Args>
+Owner* makeAggregate(std::index_sequence<Indices...>, Args&&... args)
+{
+    static_assert(std::max({alignof(Owner), alignof(Components)...}) <= alignof(std::max_align_t),
+                  "makeAggregate: new doesn't align on more than alignof(std::max_align_t) before C++17");
+    AggregateBlock<Owner, Components...> block;
+    //A braced list is evaluated from left to right: the components are built in order
+    std::tuple<Components&...> components{block.template construct<Indices, Components>()...};
+    return block.constructOwner(std::get<Indices>(components)..., std::forward<Args>(args)...);
+}
+}
+
+template<typename Owner, typename... Components, typename... Args>
+AggregatePtr<Owner> makeAggregate(Args&&... args)
+{
+    Owner* owner = detail::makeAggregate<Owner, Components...>(std::index_sequence_for<Components...>(), std::forward<Args>(args)...);
+    return AggregatePtr<Owner>(owner, &detail::destroyAggregate<Owner, Components...>);
+}
+}
+
+#endif // AGGREGATE_H
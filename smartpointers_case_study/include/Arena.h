@@ -0,0 +1,166 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "Instrumentation.h"
+
+/*An Arena hands out memory from big chunks that it gets from the heap once, instead of calling
+new and delete for every object. Freed blocks go back into a free list per size (a slab), so that
+objects that come and go reuse the same memory.*/
+
+/*When a whole group of objects dies together, like the object graph of a request, there is no need
+to free them one by one: reset() gives back all the memory of the arena at once. In that case the
+destructors are NOT called, so this is only correct for objects that own nothing outside of the
+arena (like a Fridge created by arena.create<Fridge>(arena): its FridgeImpl is inside it, and its
+Engine comes from the arena).*/
+
+namespace util
+{
+class Arena
+{
+    public:
+        explicit Arena(std::size_t chunkSize = 64 * 1024);
+        ~Arena();
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* allocate(std::size_t size, std::size_t alignment);
+        void deallocate(void* pointer, std::size_t size, std::size_t alignment) noexcept;
+
+        //Bulk reset: all the memory handed out so far is available again, without calling any destructor
+        void reset() noexcept;
+
+        template<typename T, typename... Args>
+        T* create(Args&&... args)
+        {
+            void* memory = allocate(sizeof(T), alignof(T));
+            try
+            {
+                return new (memory) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                deallocate(memory, sizeof(T), alignof(T));
+                throw;
+            }
+        }
+
+        template<typename T>
+        void destroy(T* pointer) noexcept
+        {
+            pointer->~T();
+            deallocate(pointer, sizeof(T), alignof(T));
+        }
+
+        //Each thread has its own arena, so that using it needs no lock
+        static Arena& threadLocal();
+
+    private:
+        //Blocks are rounded up to a multiple of Granularity, and recycled up to MaxRecycledSize
+        static constexpr std::size_t Granularity = alignof(std::max_align_t);
+        static constexpr std::size_t MaxRecycledSize = 512;
+
+        struct Chunk
+        {
+            char* memory;
+            std::size_t size;
+        };
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        static std::size_t roundUp(std::size_t size) noexcept;
+        void* allocateFromChunks(std::size_t size, std::size_t alignment);
+
+        std::size_t chunkSize_;
+        std::vector<Chunk> chunks_;
+        std::size_t nextChunk_ = 0;
+        char* current_ = nullptr;
+        char* end_ = nullptr;
+        FreeBlock* freeLists_[MaxRecycledSize / Granularity] = {};
+};
+
+/*A deleter for std::unique_ptr that gives the memory back to the arena it came from instead of
+calling delete. Like std::default_delete, it needs the definition of T where it is called.*/
+template<typename T>
+class ArenaDeleter
+{
+    public:
+        ArenaDeleter() noexcept = default;
+        explicit ArenaDeleter(Arena& arena) noexcept : arena_(&arena) {}
+
+        void operator()(T* pointer) const noexcept
+        {
+            arena_->destroy(pointer);
+        }
+
+        Arena* arena() const noexcept { return arena_; }
+
+    private:
+        Arena* arena_ = nullptr;
+};
+
+template<typename T>
+using ArenaUniquePtr = std::unique_ptr<T, ArenaDeleter<T>>;
+
+template<typename T, typename... Args>
+ArenaUniquePtr<T> makeArenaUnique(Arena& arena, Args&&... args)
+{
+    return ArenaUniquePtr<T>(arena.create<T>(std::forward<Args>(args)...), ArenaDeleter<T>(arena));
+}
+
+template<typename T, typename... Args>
+ArenaUniquePtr<T> makeArenaUnique(Args&&... args)
+{
+    return makeArenaUnique<T>(Arena::threadLocal(), std::forward<Args>(args)...);
+}
+
+/*ArenaPimpl is the pimpl for an impl that has to stay out of its owner, for example because its
+size can't be fixed in the header: the impl is created in an arena (the one of the thread by
+default) instead of with new, and the owner is only two pointers. An owner built in that same arena
+can then be released by Arena::reset() with the rest of its batch. When the size of the impl is
+known, FastPimpl is cheaper, and each class picks one of them. As with std::unique_ptr, T only needs
+to be complete where the owner is constructed and destroyed.*/
+template<typename T>
+class ArenaPimpl
+{
+    public:
+        ArenaPimpl() : ArenaPimpl(Arena::threadLocal()) {}
+
+        template<typename... Args>
+        explicit ArenaPimpl(Arena& arena, Args&&... args)
+            : impl_(arena.create<T>(std::forward<Args>(args)...)), arena_(&arena)
+        {
+            instrument::onAllocation<T>(impl_, sizeof(T));
+        }
+
+        ArenaPimpl(const ArenaPimpl&) = delete;
+        ArenaPimpl& operator=(const ArenaPimpl&) = delete;
+
+        ~ArenaPimpl()
+        {
+            instrument::onDeallocation<T>(impl_);
+            arena_->destroy(impl_);
+        }
+
+        Arena& arena() const noexcept { return *arena_; }
+
+        T* get() noexcept { return impl_; }
+        const T* get() const noexcept { return impl_; }
+        T* operator->() noexcept { return impl_; }
+        const T* operator->() const noexcept { return impl_; }
+        T& operator*() noexcept { return *impl_; }
+        const T& operator*() const noexcept { return *impl_; }
+
+    private:
+        T* impl_;
+        Arena* arena_;
+};
+}
+
+#endif // ARENA_H
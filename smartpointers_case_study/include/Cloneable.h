@@ -0,0 +1,200 @@
+#ifndef CLONEABLE_H
+#define CLONEABLE_H
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "Arena.h"
+
+/*Covariant clone() with smart pointers. A virtual function can't return std::unique_ptr<Derived>
+where the base returns std::unique_ptr<Base>, since the two are unrelated types. Cloneable puts
+the covariance in a private virtual function that returns a raw pointer, and hides it behind a
+non-virtual clone() that each class of the hierarchy gets with its own return type:
+class Shape : public util::Cloneable<util::Abstract<Shape>> {...};
+class Circle : public util::Cloneable<Circle, Shape> {...};
+std::unique_ptr<Circle> c = circle.clone();
+std::unique_ptr<Shape> s = shape.clone();
+Several bases give multiple inheritance (Cloneable<D, B1, B2>), a Cloneable base gives a deep
+hierarchy, and util::Virtual<A> inherits A virtually, for diamonds:
+class B : public util::Cloneable<B, util::Virtual<A>> {...};
+class C : public util::Cloneable<C, util::Virtual<A>> {...};
+class D : public util::Cloneable<D, B, C> {...};
+With a single base, using Cloneable::Cloneable gives the constructors of that base. A virtual base
+needs a default constructor, since Cloneable<B, Virtual<A>> doesn't know how to build it, but the
+most derived class still constructs it with any arguments.*/
+
+/*clone(arena) copies the object into an Arena instead of the heap. If the class has a constructor
+Derived(const Derived&, util::Arena&), it is used instead of the copy constructor, so that it can
+clone its own children into the same arena: a whole tree is then copied into the chunks of the
+arena, without one new per node. The result is a ClonePtr, whose deleter gives the memory back to
+the arena with the real size of the object, even through a pointer to a base.*/
+
+namespace util
+{
+//Cloneable<Abstract<Derived>, Bases...> is an abstract class: clone() is left to the derived classes
+template<typename T>
+struct Abstract;
+
+//A virtual base of a Cloneable. As always with virtual bases, the most derived class constructs it
+template<typename Base>
+class Virtual : public virtual Base
+{
+    public:
+        Virtual() = default;
+        Virtual(const Virtual&) = default;
+        Virtual(Virtual&&) = default;
+        Virtual& operator=(const Virtual&) = default;
+        //A copy: the assignment of a diamond reaches the virtual base once per path, and a move would leave it empty
+        Virtual& operator=(Virtual&& other)
+        {
+            Base::operator=(static_cast<const Base&>(other));
+            return *this;
+        }
+};
+
+//Deletes a clone: with delete if it was made by clone(), in its arena if it was made by clone(arena)
+template<typename T>
+class CloneDeleter
+{
+    public:
+        CloneDeleter() noexcept = default;
+        explicit CloneDeleter(Arena& arena) noexcept : arena_(&arena) {}
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+        CloneDeleter(const CloneDeleter<U>& other) noexcept : arena_(other.arena()) {}
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+        CloneDeleter(const std::default_delete<U>&) noexcept {}
+
+        void operator()(T* pointer) const noexcept
+        {
+            if (arena_)
+            {
+                pointer->destroyIn(*arena_);
+            }
+            else
+            {
+                delete pointer;
+            }
+        }
+
+        Arena* arena() const noexcept { return arena_; }
+
+    private:
+        Arena* arena_ = nullptr;
+};
+
+template<typename T>
+using ClonePtr = std::unique_ptr<T, CloneDeleter<T>>;
+
+namespace detail
+{
+template<typename... Types>
+struct TypeList;
+
+//True if a Cloneable with these bases passes Args to the constructor of its only base. The base
+//is often abstract, so std::is_constructible can't tell if it has such a constructor.
+template<typename Self, typename BaseList, typename... Args>
+struct ForwardsToBase : std::false_type
+{
+};
+
+//Not for a copy or a move of the Cloneable itself, or of a class derived from it, nor for the
+//Derived(const Derived&, util::Arena&) constructor that clone(arena) looks for
+template<typename Self, typename Base, typename First, typename... Rest>
+struct ForwardsToBase<Self, TypeList<Base>, First, Rest...> : std::integral_constant<bool, !std::is_base_of<Self, std::decay_t<First>>::value>
+{
+};
+}
+
+template<typename Derived, typename... Bases>
+class Cloneable : public Bases...
+{
+    public:
+        //The constructors of a single base, like using Base::Base
+        template<typename... Args, typename = std::enable_if_t<detail::ForwardsToBase<Cloneable, detail::TypeList<Bases...>, Args...>::value>>
+        explicit Cloneable(Args&&... args) : Bases(std::forward<Args>(args)...)...
+        {
+        }
+        Cloneable() = default;
+        Cloneable(const Cloneable&) = default;
+        Cloneable(Cloneable&&) = default;
+        Cloneable& operator=(const Cloneable&) = default;
+        Cloneable& operator=(Cloneable&&) = default;
+        virtual ~Cloneable() = default;
+
+        std::unique_ptr<Derived> clone() const
+        {
+            return std::unique_ptr<Derived>(static_cast<Derived*>(cloneRaw()));
+        }
+
+        ClonePtr<Derived> clone(Arena& arena) const
+        {
+            return ClonePtr<Derived>(static_cast<Derived*>(cloneRaw(arena)), CloneDeleter<Derived>(arena));
+        }
+
+    private:
+        template<typename T>
+        friend class CloneDeleter;
+
+        //Overrides those of all the bases, with a covariant return type
+        virtual Cloneable* cloneRaw() const
+        {
+            return new Derived(static_cast<const Derived&>(*this));
+        }
+
+        virtual Cloneable* cloneRaw(Arena& arena) const
+        {
+            return createIn(arena, std::is_constructible<Derived, const Derived&, Arena&>());
+        }
+
+        Derived* createIn(Arena& arena, std::true_type) const
+        {
+            return arena.create<Derived>(static_cast<const Derived&>(*this), arena);
+        }
+
+        Derived* createIn(Arena& arena, std::false_type) const
+        {
+            return arena.create<Derived>(static_cast<const Derived&>(*this));
+        }
+
+        virtual void destroyIn(Arena& arena) noexcept
+        {
+            arena.destroy(static_cast<Derived*>(this));
+        }
+};
+
+template<typename Derived, typename... Bases>
+class Cloneable<Abstract<Derived>, Bases...> : public Bases...
+{
+    public:
+        //The constructors of a single base, like using Base::Base
+        template<typename... Args, typename = std::enable_if_t<detail::ForwardsToBase<Cloneable, detail::TypeList<Bases...>, Args...>::value>>
+        explicit Cloneable(Args&&... args) : Bases(std::forward<Args>(args)...)...
+        {
+        }
+        Cloneable() = default;
+        Cloneable(const Cloneable&) = default;
+        Cloneable(Cloneable&&) = default;
+        Cloneable& operator=(const Cloneable&) = default;
+        Cloneable& operator=(Cloneable&&) = default;
+        virtual ~Cloneable() = default;
+
+        std::unique_ptr<Derived> clone() const
+        {
+            return std::unique_ptr<Derived>(static_cast<Derived*>(cloneRaw()));
+        }
+
+        ClonePtr<Derived> clone(Arena& arena) const
+        {
+            return ClonePtr<Derived>(static_cast<Derived*>(cloneRaw(arena)), CloneDeleter<Derived>(arena));
+        }
+
+    private:
+        template<typename T>
+        friend class CloneDeleter;
+
+        virtual Cloneable* cloneRaw() const = 0;
+        virtual Cloneable* cloneRaw(Arena& arena) const = 0;
+        virtual void destroyIn(Arena& arena) noexcept = 0;
+};
+}
+
+#endif // CLONEABLE_H
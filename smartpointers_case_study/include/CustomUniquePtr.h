@@ -0,0 +1,134 @@
+#ifndef CUSTOMUNIQUEPTR_H
+#define CUSTOMUNIQUEPTR_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "DeleterTraits.h"
+#include "Instrumentation.h"
+
+/*The unique interface for custom deleters of main.cpp. CustomUniquePtr is the version of the
+document: a std::unique_ptr to const with a function pointer as deleter, doDelete or doNotDelete.
+It works, but the function pointer doubles the size of the unique_ptr (16 bytes instead of 8), and
+every destruction is an indirect call that the compiler can't inline.*/
+
+/*TaggedUniquePtr makes the same choice, delete or not delete, with a single bit. Objects are
+aligned on at least 2 bytes, so the lowest bit of their address is always 0: TaggedUniquePtr sets
+it for the objects it doesn't own. It stays the size of a pointer, and destroying it is a test on
+that bit followed by a call to DeleterTraits<T>::dispose (a delete, unless the type declares
+otherwise, see DeleterTraits.h) that can be inlined. MakeConstUnique and MakeConstUniqueNoDelete
+build TaggedUniquePtrs, so the call sites of the document don't change:
+auto myComputer = util::MakeConstUnique(new store::electronics::gaming::Computer);
+Blueprint blueprint;
+House house(util::MakeConstUniqueNoDelete(&blueprint));*/
+
+namespace util
+{
+template<typename T>
+void doDelete(const T* p)
+{
+    delete p;
+}
+
+template<typename T>
+void doNotDelete(const T*)
+{
+}
+
+template<typename T>
+using CustomUniquePtr = std::unique_ptr<const T, void(*)(const T*)>;
+
+template<typename T>
+class TaggedUniquePtr
+{
+    public:
+        TaggedUniquePtr() noexcept = default;
+        TaggedUniquePtr(std::nullptr_t) noexcept {}
+
+        TaggedUniquePtr(const T* pointer, bool owns) noexcept : bits_(encode(pointer, owns)) {}
+
+        TaggedUniquePtr(TaggedUniquePtr&& other) noexcept : bits_(other.bits_) { other.bits_ = 0; }
+
+        //Like std::unique_ptr<Base> from std::unique_ptr<Derived>, for instance Instructions from Blueprint
+        template<typename U, typename = std::enable_if_t<std::is_convertible<const U*, const T*>::value>>
+        TaggedUniquePtr(TaggedUniquePtr<U>&& other) noexcept
+        {
+            bool const owns = other.owns();
+            bits_ = encode(other.release(), owns);
+        }
+
+        TaggedUniquePtr(const TaggedUniquePtr&) = delete;
+        TaggedUniquePtr& operator=(const TaggedUniquePtr&) = delete;
+
+        TaggedUniquePtr& operator=(TaggedUniquePtr&& other) noexcept
+        {
+            TaggedUniquePtr(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~TaggedUniquePtr()
+        {
+            if (!bits_ || (bits_ & NotOwned))
+            {
+                return;
+            }
+            //Like std::default_delete, refuse to delete a type that is only forward declared
+            static_assert(sizeof(T) > 0, "TaggedUniquePtr: can't delete an incomplete type");
+            instrument::onEvent<std::remove_const_t<T>>(instrument::Event::DeleterCall);
+            //Owning the object allows to dispose of it, even through a pointer to const
+            DeleterTraits<std::remove_const_t<T>>::dispose(const_cast<std::remove_const_t<T>*>(get()));
+        }
+
+        const T* get() const noexcept { return reinterpret_cast<const T*>(bits_ & ~NotOwned); }
+        const T& operator*() const noexcept { return *get(); }
+        const T* operator->() const noexcept { return get(); }
+        explicit operator bool() const noexcept { return get() != nullptr; }
+
+        //True if the object is deleted with this pointer, false if it comes from the stack or elsewhere
+        bool owns() const noexcept { return get() && !(bits_ & NotOwned); }
+
+        const T* release() noexcept
+        {
+            const T* pointer = get();
+            bits_ = 0;
+            return pointer;
+        }
+
+        /*Unlike std::unique_ptr::reset, the new resource comes with its own ownership: this is the
+        reset with a deleter that main.cpp looks for in the even/odd numbers example.*/
+        void reset(const T* pointer = nullptr, bool owns = true) noexcept
+        {
+            TaggedUniquePtr(pointer, owns).swap(*this);
+        }
+
+        void swap(TaggedUniquePtr& other) noexcept { std::swap(bits_, other.bits_); }
+
+    private:
+        static constexpr std::uintptr_t NotOwned = 1;
+
+        static std::uintptr_t encode(const T* pointer, bool owns) noexcept
+        {
+            static_assert(alignof(T) >= 2, "TaggedUniquePtr: T must be aligned on at least 2 bytes to free a tag bit");
+            return reinterpret_cast<std::uintptr_t>(pointer) | (owns || !pointer ? 0 : NotOwned);
+        }
+
+        std::uintptr_t bits_ = 0;
+};
+
+template<typename T>
+TaggedUniquePtr<T> MakeConstUnique(T* pointer, instrument::CallSite site = instrument::CallSite::current())
+{
+    instrument::onEvent<T>(instrument::Event::Adopt, site);
+    return TaggedUniquePtr<T>(pointer, true);
+}
+
+template<typename T>
+TaggedUniquePtr<T> MakeConstUniqueNoDelete(T* pointer, instrument::CallSite site = instrument::CallSite::current())
+{
+    instrument::onEvent<T>(instrument::Event::Adopt, site);
+    return TaggedUniquePtr<T>(pointer, false);
+}
+}
+
+#endif // CUSTOMUNIQUEPTR_H
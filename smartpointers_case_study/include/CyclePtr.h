@@ -0,0 +1,384 @@
+#ifndef CYCLEPTR_H
+#define CYCLEPTR_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*The House/neighbour example of main.cpp leaks because the two shared_ptrs keep each other alive,
+and the fix is to find the back edge and make it a weak_ptr. In a large object graph, some of
+these back edges are bound to be missed.*/
+
+/*CyclePtr is a reference-counted pointer whose cycles are reclaimed by a CycleCollector, with the
+trial deletion of Bacon and Rajan ("Concurrent Cycle Collection in Reference Counted Systems",
+2001). When a count goes down without reaching zero, the object might be the last link to a
+garbage cycle, so the collector buffers it as a candidate root. A collection gathers the subgraph
+reachable from the candidates and counts the references internal to it: the objects that are only
+referenced from inside the subgraph, and that no other object of the subgraph keeps alive, are
+garbage.*/
+
+/*Objects opt in by deriving from Collectable and listing their CyclePtrs in trace():
+struct House : util::Collectable
+{
+    util::CyclePtr<House> neighbour;
+    void trace(util::CycleTracer& tracer) override { tracer(neighbour); }
+};
+auto house1 = util::makeCyclePtr<House>();
+auto house2 = util::makeCyclePtr<House>();
+house1->neighbour = house2;
+house2->neighbour = house1;
+//Both are reclaimed by the next collect() after house1 and house2 go out of scope*/
+
+/*The counts are atomic, and copies, moves and destructions of CyclePtrs don't take a lock: the
+only lock of a mutator is the one that buffers a candidate root. As with shared_ptr, one CyclePtr
+object must not be changed by two threads at once. An object may only point to objects of its own
+collector.*/
+
+/*step(budget) does at most budget nodes of work on a collection, and the next step resumes where
+it stopped, so the mutators keep running between steps, and a background thread (startBackground())
+only stops them for one step at a time. Since the graph changes under a collection, every reference
+operation on an object also bumps a version kept next to its count, and the garbage is only
+reclaimed if none of its versions changed while the collection looked at it. Otherwise its
+candidates go back to the buffer, for a later collection. A mutator that releases the last
+reference to an object while a step traces waits for that step, which might have read the object.*/
+
+/*trace() runs on the collector's thread. Single CyclePtr members are safe, since their loads and
+stores are atomic, but a container of CyclePtrs, like a std::vector that reallocates, is not: while
+the collector runs in the background, the mutators must hold collector.lock() when they change a
+container that trace() walks, and must not call collect() or step() while they hold it.
+{
+    auto lock = collector.lock();
+    house->neighbours.push_back(other);
+}*/
+
+namespace util
+{
+class Collectable;
+class CycleCollector;
+class CycleTracer;
+template<typename T>
+class CyclePtr;
+
+//The type-erased part of CyclePtr, that the collector walks through
+class CyclePtrBase
+{
+    protected:
+        CyclePtrBase() noexcept = default;
+        explicit CyclePtrBase(Collectable* object) noexcept : object_(object) {}
+
+        //Only the owner of the CyclePtr changes it, the collector can read it at any time
+        Collectable* load() const noexcept { return object_.load(std::memory_order_relaxed); }
+        void store(Collectable* object) noexcept { object_.store(object, std::memory_order_release); }
+
+    private:
+        friend class CycleCollector;
+
+        std::atomic<Collectable*> object_{nullptr};
+};
+
+class CycleTracer
+{
+    public:
+        void operator()(CyclePtrBase& edge) { visit(edge); }
+
+    protected:
+        ~CycleTracer() = default;
+
+    private:
+        virtual void visit(CyclePtrBase& edge) = 0;
+};
+
+class Collectable
+{
+    public:
+        virtual ~Collectable() = default;
+
+    protected:
+        Collectable() noexcept = default;
+        //A copy is a new object, with its own count
+        Collectable(const Collectable&) noexcept {}
+        Collectable& operator=(const Collectable&) noexcept { return *this; }
+
+    private:
+        friend class CycleCollector;
+
+        //Calls tracer(member) for every CyclePtr member
+        virtual void trace(CycleTracer& tracer) = 0;
+
+        //The count is the low half of counter_, and every reference operation bumps the high half
+        static constexpr std::uint64_t Version = std::uint64_t(1) << 32;
+        static constexpr std::uint64_t CountMask = Version - 1;
+        /*Whether the collector holds the object, as a buffered root or as part of the collection:
+        when its count reaches zero, Released tells the collector to delete it.*/
+        enum Flag : std::uint8_t { Rooted = 1, Traced = 2, Released = 4 };
+        //Where the current collection is with the object
+        enum class Mark : std::uint8_t { None, Unknown, Live, Garbage, Detached };
+        static constexpr std::size_t NotBuffered = static_cast<std::size_t>(-1);
+
+        CycleCollector* collector_ = nullptr;
+        std::atomic<std::uint64_t> counter_{0};
+        std::atomic<std::uint8_t> flags_{0};
+        //Only used by the collector, and rootIndex_ under its roots mutex
+        Mark mark_ = Mark::None;
+        std::size_t rootIndex_ = NotBuffered;
+        std::size_t internal_ = 0;
+        std::uint64_t snapshot_ = 0;
+};
+
+class CycleCollector
+{
+    public:
+        struct Statistics
+        {
+            std::size_t cyclesReclaimed = 0;
+            std::size_t objectsReclaimed = 0;
+            std::size_t collections = 0;
+            //The longest time a step kept the mutators that release objects waiting
+            std::chrono::nanoseconds longestPause{0};
+        };
+
+        CycleCollector() = default;
+        //Stops the background thread and reclaims the cycles that are left
+        ~CycleCollector();
+        CycleCollector(const CycleCollector&) = delete;
+        CycleCollector& operator=(const CycleCollector&) = delete;
+
+        /*Runs collections until they stop finding garbage, and returns the number of objects
+        reclaimed. Each collection is a single step with no budget.*/
+        std::size_t collect();
+
+        /*Does at most budget nodes of work, on the current collection or on a new one if candidate
+        roots are buffered, and returns the number of objects reclaimed.*/
+        std::size_t step(std::size_t budget = 1024);
+
+        //Calls step(budget) every interval on a background thread, until stopBackground()
+        void startBackground(std::chrono::milliseconds interval, std::size_t budget = 1024);
+        void stopBackground();
+
+        Statistics statistics() const;
+        std::size_t candidateRoots() const;
+
+        //Keeps the collector from tracing while a container of CyclePtrs is changed
+        std::unique_lock<std::recursive_mutex> lock() const { return std::unique_lock<std::recursive_mutex>(sliceMutex_); }
+
+        //The collector of makeCyclePtr when none is given
+        static CycleCollector& global();
+
+        template<typename T, typename... Args>
+        CyclePtr<T> make(Args&&... args)
+        {
+            static_assert(std::is_base_of<Collectable, T>::value, "CyclePtr: T must derive from util::Collectable");
+            T* object = new T(std::forward<Args>(args)...);
+            Collectable* const collectable = object;
+            collectable->collector_ = this;
+            collectable->counter_.store(1, std::memory_order_relaxed);
+            return CyclePtr<T>(typename CyclePtr<T>::Adopt(), object);
+        }
+
+    private:
+        template<typename T>
+        friend class CyclePtr;
+        using Mark = Collectable::Mark;
+        enum class Phase : std::uint8_t { Idle, Gather, Snapshot, Count, Scan, Validate, Detach, Release, Delete };
+
+        static CycleCollector& of(Collectable* object) noexcept { return *object->collector_; }
+
+        static void increment(Collectable* object) noexcept
+        {
+            object->counter_.fetch_add(Collectable::Version + 1);
+        }
+
+        //A move: the count stays, but the collector may have seen the edge at both places
+        static void touch(Collectable* object) noexcept
+        {
+            object->counter_.fetch_add(Collectable::Version);
+        }
+
+        static void decrement(Collectable* object)
+        {
+            //Buffered while this reference still keeps the object alive
+            if ((object->counter_.load(std::memory_order_relaxed) & Collectable::CountMask) > 1
+                && !(object->flags_.load(std::memory_order_relaxed) & Collectable::Rooted))
+            {
+                of(object).buffer(object);
+            }
+            if ((object->counter_.fetch_add(Collectable::Version - 1) & Collectable::CountMask) == 1)
+            {
+                of(object).released(object);
+            }
+        }
+
+        void buffer(Collectable* object);
+        void removeRoot(Collectable* object) noexcept;
+        void released(Collectable* object);
+        template<typename F>
+        static void forEachChild(Collectable* object, F&& f);
+        static void cut(Collectable* object, std::vector<Collectable*>* pending);
+        bool hold(Collectable* object);
+        bool begin();
+        std::size_t advance(std::size_t budget);
+        void gather(std::size_t& budget);
+        void snapshot(std::size_t& budget);
+        void count(std::size_t& budget);
+        void scan(std::size_t& budget);
+        void validate(std::size_t& budget);
+        void detach(std::size_t& budget);
+        void release(std::size_t& budget);
+        std::size_t reclaim(std::size_t& budget);
+
+        //Held by the steps while they trace, and by the mutators in lock()
+        mutable std::recursive_mutex sliceMutex_;
+        std::atomic<bool> tracing_{false};
+        mutable std::mutex rootsMutex_;
+        std::vector<Collectable*> roots_;
+
+        //The collection in progress, that the steps share
+        std::mutex stepMutex_;
+        Phase phase_ = Phase::Idle;
+        bool aborted_ = false;
+        //The candidates are the first objects of graph_
+        std::size_t candidates_ = 0;
+        std::size_t cursor_ = 0;
+        std::vector<Collectable*> graph_;
+        std::vector<Collectable*> pending_;
+        std::vector<Collectable*> garbage_;
+        std::vector<Collectable*> released_;
+
+        mutable std::mutex statisticsMutex_;
+        Statistics statistics_;
+
+        std::thread background_;
+        std::mutex backgroundMutex_;
+        std::condition_variable backgroundWakeUp_;
+        bool stopping_ = false;
+};
+
+template<typename T>
+class CyclePtr : public CyclePtrBase
+{
+    public:
+        CyclePtr() noexcept = default;
+        CyclePtr(std::nullptr_t) noexcept {}
+
+        CyclePtr(const CyclePtr& other) noexcept : CyclePtrBase(other.load())
+        {
+            if (Collectable* const object = load())
+            {
+                CycleCollector::increment(object);
+            }
+        }
+
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+        CyclePtr(const CyclePtr<U>& other) noexcept : CyclePtrBase(static_cast<T*>(other.get()))
+        {
+            if (Collectable* const object = load())
+            {
+                CycleCollector::increment(object);
+            }
+        }
+
+        CyclePtr(CyclePtr&& other) noexcept : CyclePtrBase(other.load())
+        {
+            if (Collectable* const object = load())
+            {
+                CycleCollector::touch(object);
+                other.store(nullptr);
+            }
+        }
+
+        CyclePtr& operator=(const CyclePtr& other)
+        {
+            Collectable* const object = other.load();
+            if (object)
+            {
+                CycleCollector::increment(object);
+            }
+            replace(object);
+            return *this;
+        }
+
+        CyclePtr& operator=(CyclePtr&& other)
+        {
+            if (this == &other)
+            {
+                return *this;
+            }
+            Collectable* const object = other.load();
+            if (object)
+            {
+                CycleCollector::touch(object);
+                other.store(nullptr);
+            }
+            replace(object);
+            return *this;
+        }
+
+        ~CyclePtr()
+        {
+            reset();
+        }
+
+        void reset()
+        {
+            replace(nullptr);
+        }
+
+        void swap(CyclePtr& other) noexcept
+        {
+            Collectable* const object = load();
+            Collectable* const otherObject = other.load();
+            if (object)
+            {
+                CycleCollector::touch(object);
+            }
+            if (otherObject)
+            {
+                CycleCollector::touch(otherObject);
+            }
+            store(otherObject);
+            other.store(object);
+        }
+
+        T* get() const noexcept { return static_cast<T*>(load()); }
+        T& operator*() const noexcept { return *get(); }
+        T* operator->() const noexcept { return get(); }
+        explicit operator bool() const noexcept { return load() != nullptr; }
+
+    private:
+        friend class CycleCollector;
+
+        struct Adopt {};
+        CyclePtr(Adopt, T* object) noexcept : CyclePtrBase(object) {}
+
+        //The edge is cleared before the old object is released, the collector relies on it
+        void replace(Collectable* object)
+        {
+            Collectable* const old = load();
+            store(object);
+            if (old)
+            {
+                CycleCollector::decrement(old);
+            }
+        }
+};
+
+template<typename T, typename... Args>
+CyclePtr<T> makeCyclePtr(CycleCollector& collector, Args&&... args)
+{
+    return collector.make<T>(std::forward<Args>(args)...);
+}
+
+template<typename T, typename... Args>
+CyclePtr<T> makeCyclePtr(Args&&... args)
+{
+    return CycleCollector::global().make<T>(std::forward<Args>(args)...);
+}
+}
+
+#endif // CYCLEPTR_H
@@ -0,0 +1,186 @@
+#ifndef DEFERREDRECLAIMER_H
+#define DEFERREDRECLAIMER_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+/*When the last owner of a big structure goes away, like a std::set<std::unique_ptr<Base>> going
+out of scope after the set transfer of main.cpp, or the last shared_ptr to a graph, the thread that
+drops it pays for the whole teardown: a destructor and a delete per node. On a latency-critical
+thread, that is a spike of the whole size of the structure.*/
+
+/*A DeferredReclaimer takes the objects to delete instead, and deletes them on a background thread,
+in batches. Handing over an object is a push on a bounded lock-free queue: two atomic operations,
+with no lock and no allocation. The capacity of the queue is the back-pressure limit: when the
+reclaimer falls behind and the queue is full, retire() either deletes the object itself, like if
+there were no reclaimer (Overflow::DeleteInline), or waits for room (Overflow::Wait). The deleters
+run on the reclaimer thread, so the objects must not be used by anyone anymore, and their
+destructors must be fine with running on another thread.*/
+
+/*The ways in:
+std::unique_ptr<Node, util::DeferredDelete<Node>> node(new Node);   // a deleter policy
+util::CustomUniquePtr<Node>(new Node, util::doDeferredDelete<Node>); // the function pointer style
+auto graph = util::makeDeferredShared<Graph>();                     // deleted off the thread of the last owner
+util::deferDestruction(std::move(set));                             // a whole container, in one push
+TaggedUniquePtr and MakeConstUnique go through DeleterTraits<T>::dispose, which can call
+DeferredReclaimer::global().retire(pointer) for the types that should always be deferred.*/
+
+namespace util
+{
+class DeferredReclaimer
+{
+    public:
+        enum class Overflow
+        {
+            DeleteInline, //the caller deletes the object itself
+            Wait          //the caller waits until the reclaimer makes room
+        };
+
+        struct Statistics
+        {
+            std::uint64_t deferred;      //objects that went through the queue
+            std::uint64_t deletedInline; //objects deleted by the caller because the queue was full
+            std::uint64_t waits;         //retire() calls that had to wait for room
+            std::uint64_t reclaimed;     //objects deleted by the reclaimer, or by drain()
+            std::uint64_t batches;
+        };
+
+        //capacity is rounded up to a power of 2; the background thread wakes up every interval, or when batchSize objects are waiting
+        explicit DeferredReclaimer(std::size_t capacity = 65536, Overflow overflow = Overflow::DeleteInline,
+                                   std::size_t batchSize = 256, std::chrono::milliseconds interval = std::chrono::milliseconds(1));
+        //Deletes everything still queued, then stops the background thread
+        ~DeferredReclaimer();
+        DeferredReclaimer(const DeferredReclaimer&) = delete;
+        DeferredReclaimer& operator=(const DeferredReclaimer&) = delete;
+
+        void retire(void* pointer, void (*deleter)(void*));
+
+        template<typename T>
+        void retire(T* pointer)
+        {
+            static_assert(sizeof(T) > 0, "DeferredReclaimer: can't delete an incomplete type");
+            if (pointer)
+            {
+                retire(const_cast<std::remove_const_t<T>*>(pointer), [](void* p) { delete static_cast<T*>(p); });
+            }
+        }
+
+        /*Waits until the reclaimer has deleted everything that was retired before the call. Called
+        from one of its own deleters, it returns at once: the deleters queued after it can't run before.*/
+        void flush();
+        //Deletes everything queued on the calling thread, and returns how many objects that was (none from one of its deleters)
+        std::size_t drain();
+
+        Statistics statistics() const noexcept;
+
+        //The reclaimer of the process, started on first use
+        static DeferredReclaimer& global();
+
+    private:
+        struct Entry
+        {
+            void* pointer;
+            void (*deleter)(void*);
+        };
+
+        //A cell is free for the producer of position p when sequence == p, full for the consumer when sequence == p + 1
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence;
+            Entry entry;
+        };
+
+        bool tryPush(Entry entry, std::size_t& position) noexcept;
+        bool tryPop(Entry& entry) noexcept;
+        //Deletes up to batchSize_ queued objects; the caller holds consumerMutex_
+        std::size_t reclaimBatch();
+        void run();
+
+        std::unique_ptr<Cell[]> cells_;
+        std::size_t const mask_;
+        std::size_t const batchSize_;
+        Overflow const overflow_;
+        std::chrono::milliseconds const interval_;
+
+        //Producers and the consumer on different cache lines (new doesn't align on more than alignof(std::max_align_t) before C++17)
+        char padding0_[64];
+        std::atomic<std::size_t> enqueuePosition_{0};
+        char padding1_[64];
+        std::size_t dequeuePosition_ = 0;
+        char padding2_[64];
+
+        std::atomic<std::uint64_t> deletedInline_{0};
+        std::atomic<std::uint64_t> waits_{0};
+        std::atomic<std::uint64_t> reclaimed_{0};
+        std::atomic<std::uint64_t> batches_{0};
+
+        //Serializes the consumers: the background thread and the callers of drain()
+        std::mutex consumerMutex_;
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        std::condition_variable reclaimedSome_;
+        std::atomic<bool> urgent_{false};
+        bool stopping_ = false;
+        std::thread thread_;
+};
+
+//A deleter policy for std::unique_ptr and std::shared_ptr. Without a reclaimer, it uses the global one
+template<typename T>
+class DeferredDelete
+{
+    public:
+        DeferredDelete() noexcept = default;
+        explicit DeferredDelete(DeferredReclaimer& reclaimer) noexcept : reclaimer_(&reclaimer) {}
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+        DeferredDelete(const DeferredDelete<U>& other) noexcept : reclaimer_(other.reclaimer()) {}
+
+        void operator()(T* pointer) const
+        {
+            (reclaimer_ ? *reclaimer_ : DeferredReclaimer::global()).retire(pointer);
+        }
+
+        DeferredReclaimer* reclaimer() const noexcept { return reclaimer_; }
+
+    private:
+        DeferredReclaimer* reclaimer_ = nullptr;
+};
+
+template<typename T>
+using DeferredUniquePtr = std::unique_ptr<T, DeferredDelete<T>>;
+
+template<typename T, typename... Args>
+DeferredUniquePtr<T> makeDeferredUnique(Args&&... args)
+{
+    return DeferredUniquePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+//The object is deleted by the reclaimer, the control block by the last owner
+template<typename T, typename... Args>
+std::shared_ptr<T> makeDeferredShared(Args&&... args)
+{
+    return std::shared_ptr<T>(new T(std::forward<Args>(args)...), DeferredDelete<T>());
+}
+
+//Like doDelete and doNotDelete in CustomUniquePtr.h
+template<typename T>
+void doDeferredDelete(const T* pointer)
+{
+    DeferredReclaimer::global().retire(pointer);
+}
+
+//Moves value, a container or a whole tree, into a single heap object that the reclaimer destroys
+template<typename T>
+void deferDestruction(T&& value, DeferredReclaimer& reclaimer = DeferredReclaimer::global())
+{
+    reclaimer.retire(new std::decay_t<T>(std::forward<T>(value)));
+}
+}
+
+#endif // DEFERREDRECLAIMER_H
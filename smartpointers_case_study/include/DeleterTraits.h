@@ -0,0 +1,108 @@
+#ifndef DELETERTRAITS_H
+#define DELETERTRAITS_H
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/*The "Specific deleters" section of main.cpp specializes util::MakeConstUnique for Computer so
+that it passes specificFunctionThatFreesAComputer to the unique_ptr. The deleter is still a
+function pointer stored in every unique_ptr and called indirectly.*/
+
+/*With DeleterTraits, a type declares once, next to its definition, how it is disposed of:
+namespace util
+{
+template<>
+struct DeleterTraits<store::electronics::gaming::Computer>
+{
+    static void dispose(store::electronics::gaming::Computer* computer)
+    {
+        specificFunctionThatFreesAComputer(computer);
+    }
+};
+}
+TraitsDeleter<T> then calls it. It is an empty class known at compile time, so a
+std::unique_ptr<T, TraitsDeleter<T>> is the size of a pointer and the call is inlined. The same
+traits are used by util::MakeConstUnique (see CustomUniquePtr.h).*/
+
+namespace util
+{
+template<typename T>
+struct DeleterTraits
+{
+    static void dispose(T* p)
+    {
+        static_assert(sizeof(T) > 0, "DeleterTraits: can't delete an incomplete type");
+        delete p;
+    }
+};
+
+//C files are closed, not deleted
+template<>
+struct DeleterTraits<std::FILE>
+{
+    static void dispose(std::FILE* file)
+    {
+        std::fclose(file);
+    }
+};
+
+/*The traits of Computer also apply to a unique_ptr to const Computer. Like std::default_delete,
+a TraitsDeleter<Derived> converts to a TraitsDeleter<Base>, which disposes of the object with the
+traits of Base (a delete through the virtual destructor, by default).*/
+template<typename T>
+struct TraitsDeleter
+{
+    TraitsDeleter() noexcept = default;
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+    TraitsDeleter(const TraitsDeleter<U>&) noexcept {}
+
+    void operator()(T* p) const
+    {
+        DeleterTraits<std::remove_const_t<T>>::dispose(const_cast<std::remove_const_t<T>*>(p));
+    }
+};
+
+template<typename T>
+using TraitsUniquePtr = std::unique_ptr<T, TraitsDeleter<T>>;
+
+template<typename T>
+TraitsUniquePtr<T> MakeTraitsUnique(T* pointer)
+{
+    return TraitsUniquePtr<T>(pointer);
+}
+
+/*For the legacy C functions that don't belong to one type, like free or
+oldFunctionThatDeallocatesAGizmo, the function itself can be the template argument:
+using GizmoUniquePtr = std::unique_ptr<Gizmo, util::FunctionDeleter<Gizmo, oldFunctionThatDeallocatesAGizmo>>;*/
+template<typename T, void(*Dispose)(T*)>
+struct FunctionDeleter
+{
+    void operator()(T* p) const
+    {
+        Dispose(p);
+    }
+};
+
+//Memory from malloc/calloc/realloc, also through a pointer to const like MallocUniquePtr<const char>
+struct FreeDeleter
+{
+    void operator()(const void* p) const
+    {
+        std::free(const_cast<void*>(p));
+    }
+};
+
+template<typename T>
+using MallocUniquePtr = std::unique_ptr<T, FreeDeleter>;
+
+using FileUniquePtr = TraitsUniquePtr<std::FILE>;
+
+static_assert(sizeof(FileUniquePtr) == sizeof(std::FILE*), "TraitsDeleter must not take any room");
+static_assert(sizeof(MallocUniquePtr<char>) == sizeof(char*), "FreeDeleter must not take any room");
+static_assert(std::is_same<decltype(FreeDeleter()(std::declval<const char*>())), void>::value, "FreeDeleter must accept pointers to const");
+}
+
+#endif // DELETERTRAITS_H
@@ -0,0 +1,182 @@
+#ifndef EPOCHPTR_H
+#define EPOCHPTR_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+/*Read-mostly data like a configuration or a routing table is typically shared with a
+std::shared_ptr that writers replace with std::atomic_store and readers copy with std::atomic_load.
+Every reader then increments and decrements the same count, so all the cores write to the same
+cache line (and libstdc++ even takes a lock for atomic_load on a shared_ptr).*/
+
+/*EpochPtr<T> is an atomic pointer to the current version, with epoch-based reclamation. A reader
+pins the global epoch in a slot of its own thread, on its own cache line, reads the pointer, and
+unpins it when done: it never writes to memory shared with the other readers. A writer swaps in
+the new version and retires the old one, which is deleted once every pinned reader has moved past
+the epoch of the swap:
+util::EpochPtr<RoutingTable> routes(std::make_unique<RoutingTable>());
+{
+    auto table = routes.read();  // pinned until the end of the scope
+    table->lookup(address);
+}
+routes.store(std::make_unique<RoutingTable>(newRoutes));
+A reader that stays pinned for long keeps all the versions retired since from being deleted, so
+read() guards are meant to be short-lived, like a lock_guard. The retired versions are deleted in
+batches by the writers, and what is left when an EpochPtr is destroyed or a thread exits.*/
+
+namespace util
+{
+class Epoch
+{
+    private:
+        struct Record;
+
+    public:
+        //Keeps the versions read while it exists from being deleted. Can be nested
+        class Guard
+        {
+            public:
+                Guard() noexcept : record_(&pin()) {}
+                Guard(Guard&& other) noexcept : record_(other.record_) { other.record_ = nullptr; }
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+                Guard& operator=(Guard&&) = delete;
+                ~Guard()
+                {
+                    if (record_)
+                    {
+                        unpin(*record_);
+                    }
+                }
+
+            private:
+                Record* record_;
+        };
+
+        //Calls deleter(pointer) once no reader can still be using pointer
+        static void retire(void* pointer, void (*deleter)(void*));
+
+        //Deletes what can be deleted now, and returns how many retired objects are left
+        static std::size_t reclaim();
+
+    private:
+        static constexpr std::uint64_t Idle = std::numeric_limits<std::uint64_t>::max();
+
+        struct alignas(64) Record
+        {
+            std::atomic<std::uint64_t> pinned{Idle};
+            std::atomic<bool> used{true};
+            Record* next = nullptr;
+            unsigned nesting = 0;
+        };
+
+        //The record of the calling thread
+        static Record& local() noexcept;
+
+        static Record& pin() noexcept
+        {
+            Record& record = local();
+            if (record.nesting++ == 0)
+            {
+                record.pinned.store(global_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                //The slot must be visible before the pointer is read, see Epoch.cpp
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            return record;
+        }
+
+        static void unpin(Record& record) noexcept
+        {
+            if (--record.nesting == 0)
+            {
+                record.pinned.store(Idle, std::memory_order_release);
+            }
+        }
+
+        static std::atomic<std::uint64_t> global_;
+        //Records are never freed: a thread that exits leaves its record to the next thread
+        static std::atomic<Record*> records_;
+};
+
+template<typename T>
+class EpochPtr
+{
+    public:
+        //The version that was current when read() was called, valid as long as the ReadGuard lives
+        class ReadGuard
+        {
+            public:
+                const T* get() const noexcept { return value_; }
+                const T& operator*() const noexcept { return *value_; }
+                const T* operator->() const noexcept { return value_; }
+                explicit operator bool() const noexcept { return value_ != nullptr; }
+
+            private:
+                friend class EpochPtr;
+                ReadGuard(Epoch::Guard guard, const T* value) noexcept : guard_(std::move(guard)), value_(value) {}
+
+                Epoch::Guard guard_;
+                const T* value_;
+        };
+
+        explicit EpochPtr(std::unique_ptr<T> value = nullptr) noexcept : current_(value.release()) {}
+        EpochPtr(const EpochPtr&) = delete;
+        EpochPtr& operator=(const EpochPtr&) = delete;
+
+        //There must be no reader left. The versions retired before are deleted too, unless a reader of another EpochPtr still holds their epoch
+        ~EpochPtr()
+        {
+            delete current_.load(std::memory_order_acquire);
+            Epoch::reclaim();
+        }
+
+        ReadGuard read() const noexcept
+        {
+            Epoch::Guard guard;
+            const T* const value = current_.load(std::memory_order_seq_cst);
+            return ReadGuard(std::move(guard), value);
+        }
+
+        //Publishes a new version. The previous one is deleted when the last reader is done with it
+        void store(std::unique_ptr<T> value)
+        {
+            retire(current_.exchange(value.release(), std::memory_order_seq_cst));
+        }
+
+        /*Publishes a modified copy of the current version, that must exist: update() copies it, calls
+        modify(copy), and starts again if another writer published in the meantime.*/
+        template<typename Modify>
+        void update(Modify modify)
+        {
+            for (;;)
+            {
+                ReadGuard const current = read();
+                std::unique_ptr<T> copy = std::make_unique<T>(*current);
+                modify(*copy);
+                T* expected = const_cast<T*>(current.get());
+                if (current_.compare_exchange_strong(expected, copy.get(), std::memory_order_seq_cst))
+                {
+                    copy.release();
+                    retire(expected);
+                    return;
+                }
+            }
+        }
+
+    private:
+        static void retire(T* value)
+        {
+            if (value)
+            {
+                Epoch::retire(value, [](void* pointer) { delete static_cast<T*>(pointer); });
+            }
+        }
+
+        std::atomic<T*> current_;
+};
+}
+
+#endif // EPOCHPTR_H
@@ -0,0 +1,88 @@
+#ifndef FASTPIMPL_H
+#define FASTPIMPL_H
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*FastPimpl keeps the implementation object inside the class that owns it, in a raw buffer whose
+size and alignment are written in the header. Clients still only see a forward declaration of the
+impl, so the pimpl idiom keeps hiding it, but building the owner no longer allocates on the heap
+and forwarding a call no longer follows a pointer.*/
+
+/*The price is that the header has to know how big the impl is. This can only be checked where the
+impl is a complete type, so the checks live in the constructor and destructor of FastPimpl: as with
+std::unique_ptr, the owner defines its constructor and destructor in its implementation file, and the
+static_asserts fire there as soon as the impl outgrows the buffer.*/
+
+namespace util
+{
+template<typename T, std::size_t Size, std::size_t Alignment>
+class FastPimpl
+{
+    public:
+        FastPimpl()
+        {
+            validate<sizeof(T), alignof(T)>();
+            new (&storage_) T();
+        }
+
+        template<typename Arg, typename... Args,
+                 typename = std::enable_if_t<!std::is_same<std::decay_t<Arg>, FastPimpl>::value>>
+        explicit FastPimpl(Arg&& arg, Args&&... args)
+        {
+            validate<sizeof(T), alignof(T)>();
+            new (&storage_) T(std::forward<Arg>(arg), std::forward<Args>(args)...);
+        }
+
+        //Copies and moves are only instantiated if the owner uses them, and then T must support them
+        FastPimpl(const FastPimpl& other)
+        {
+            new (&storage_) T(*other);
+        }
+
+        FastPimpl(FastPimpl&& other)
+        {
+            new (&storage_) T(std::move(*other));
+        }
+
+        FastPimpl& operator=(const FastPimpl& other)
+        {
+            **this = *other;
+            return *this;
+        }
+
+        FastPimpl& operator=(FastPimpl&& other)
+        {
+            **this = std::move(*other);
+            return *this;
+        }
+
+        ~FastPimpl()
+        {
+            validate<sizeof(T), alignof(T)>();
+            get()->~T();
+        }
+
+        T* get() noexcept { return reinterpret_cast<T*>(&storage_); }
+        const T* get() const noexcept { return reinterpret_cast<const T*>(&storage_); }
+        T* operator->() noexcept { return get(); }
+        const T* operator->() const noexcept { return get(); }
+        T& operator*() noexcept { return *get(); }
+        const T& operator*() const noexcept { return *get(); }
+
+    private:
+        /*The actual size and alignment are template parameters so that the compiler prints them in
+        the error message, which tells directly what to write in the header.*/
+        template<std::size_t ActualSize, std::size_t ActualAlignment>
+        static void validate() noexcept
+        {
+            static_assert(Size >= ActualSize, "FastPimpl: Size is smaller than sizeof(T)");
+            static_assert(Alignment % ActualAlignment == 0, "FastPimpl: Alignment is not a multiple of alignof(T)");
+        }
+
+        std::aligned_storage_t<Size, Alignment> storage_;
+};
+}
+
+#endif // FASTPIMPL_H
@@ -1,6 +1,14 @@
 #ifndef FRIDGE_H
 #define FRIDGE_H
-#include <memory>
+#include <cstddef>
+#include <future>
+#include "FastPimpl.h"
+
+namespace util
+{
+class Arena;
+class ThreadPool;
+}
 
 /*If Fridge.h would #include Engine.h, any client of the Fridge class would
 indirectly #include the Engine class. So when the Engine class is modified, all the clients of
@@ -14,14 +22,28 @@ class Fridge
     public:
 
         Fridge();
+        //The Engine comes from the arena, see impl_
+        explicit Fridge(util::Arena& arena);
         ~Fridge(); //We declare the destructor and thus prevent the compiler from doing it for us
         void coolDown();
+        /*Cools down count Fridges on pool, in tasks of chunkSize Fridges that idle workers steal
+        from the busy ones. The future is ready when all of them are done, and then holds the
+        first exception thrown by a chunk or by pool.submit(), if any. Each worker uses an Engine of its own, so the
+        Fridges don't need any lock, but a Fridge must not be in two batches at the same time.*/
+        static std::future<void> coolDown(Fridge* fridges, std::size_t count, util::ThreadPool& pool,
+                                          std::size_t chunkSize = 1024);
     private:
         class FridgeImpl;
-        /*std::unique_ptr happens to check in its destructor if the definition of the type is visible
-        before calling delete. So it refuses to compile and to call delete if the type is only forward
-        declared.*/
-        std::unique_ptr<FridgeImpl> impl_ = std::make_unique<FridgeImpl>();
+        /*The classic way is std::unique_ptr<FridgeImpl> impl_ = std::make_unique<FridgeImpl>(), but
+        then every Fridge costs a heap allocation and every call a pointer chase. FastPimpl stores
+        FridgeImpl right here instead. Like std::unique_ptr, it needs the definition of the type to
+        check its size, so it refuses to compile if the type is only forward declared.
+        FridgeImpl holds an Engine, which is a single vtable pointer, and a pointer to wherever the
+        Engine is. Fridge(arena) puts the Engine in an arena, the way an impl whose parts can't all
+        be sized in the header would. A batch of Fridges created with
+        arena.create<Fridge>(arena) is then entirely in the arena, and can be released all at once
+        by Arena::reset() (see Arena.h).*/
+        util::FastPimpl<FridgeImpl, 3 * sizeof(void*), alignof(void*)> impl_;
 };
 
     /*We can still use the default implementation for the destructor that the compiler would have
@@ -29,5 +51,6 @@ class Fridge
     FridgeImpl*/
 
     //For more info visit //https://herbsutter.com/gotw/_100/
+    //and about the fast pimpl //https://herbsutter.com/gotw/_028/
 
 #endif // FRIDGE_H
@@ -0,0 +1,312 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+/*Counters for what the smart pointers of this project cost at run time: allocations and their
+sizes, control blocks, calls to custom deleters, failed weak_ptr::lock()s, and how long the objects
+live, per type and per call site. The hooks are in util::MakeConstUnique and TaggedUniquePtr,
+ArenaPimpl, WeakCache, and the makeShared/makeUnique/lock helpers below
+that stand for the std::make_shared, std::make_unique and weak_ptr::lock() of main.cpp.*/
+
+/*The instrumentation only exists when the project is built with SMARTPOINTERS_INSTRUMENTATION
+defined (the Instrumented target of the Code::Blocks project, benchmark_instrumented with CMake).
+Otherwise every hook is an empty inline function, CallSite is an empty struct, TrackingDelete is a
+plain delete, and makeShared/lock are std::make_shared and weak_ptr::lock(). UniquePtr<T> is a
+std::unique_ptr<T, TrackingDelete<T>> in both builds, so code that names its deleter compiles in both.
+With the instrumentation, TrackingDelete keeps the counters of the type that makeUnique allocated,
+so that a UniquePtr<Derived> converted to a UniquePtr<Base> is still counted as a Derived: the
+UniquePtr is then two pointers.*/
+
+/*With setSamplingPeriod(n), only one allocation out of n (chosen by address, so that the same
+object is followed from its allocation to its deallocation) and one other event out of n per
+thread are recorded, with a weight of n. The other ones only cost a decrement or a hash. Changing
+the period forgets the objects in flight: their lifetimes are not recorded.*/
+
+namespace util
+{
+namespace instrument
+{
+enum class Event
+{
+    Allocation,
+    ControlBlock,
+    Adopt,
+    DeleterCall,
+    WeakLock,
+    WeakLockFailure
+};
+
+//The counters of one type, as dump() writes them
+struct Counts
+{
+    std::uint64_t operator[](Event event) const noexcept { return events[static_cast<std::size_t>(event)]; }
+
+    std::uint64_t events[static_cast<std::size_t>(Event::WeakLockFailure) + 1] = {};
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+//The deleter of UniquePtr, defined below the hooks it calls
+template<typename T>
+struct TrackingDelete;
+
+template<typename T>
+using UniquePtr = std::unique_ptr<T, TrackingDelete<T>>;
+
+#ifdef SMARTPOINTERS_INSTRUMENTATION
+constexpr bool enabled = true;
+
+//Filled in with the file and line of the caller when used as a default argument
+struct CallSite
+{
+#if defined(__GNUC__) || defined(__clang__)
+    static constexpr CallSite current(char const* file = __builtin_FILE(), int line = __builtin_LINE()) noexcept
+    {
+        return CallSite{file, line};
+    }
+#else
+    static constexpr CallSite current() noexcept { return CallSite{nullptr, 0}; }
+#endif
+    char const* file;
+    int line;
+};
+
+struct TypeStats;
+
+namespace detail
+{
+TypeStats* registerType(char const* mangledName);
+bool sampleAddress(void const* pointer) noexcept;
+bool sampleEvent() noexcept;
+void record(TypeStats* type, Event event, std::size_t size, void const* pointer, CallSite site);
+void recordDeallocation(TypeStats* type, void const* pointer);
+Counts counts(TypeStats const* type);
+
+template<typename T>
+TypeStats* statsFor()
+{
+    static TypeStats* const stats = registerType(typeid(T).name());
+    return stats;
+}
+}
+
+template<typename T>
+void onAllocation(void const* pointer, std::size_t size, CallSite site = CallSite{nullptr, 0})
+{
+    if (detail::sampleAddress(pointer))
+    {
+        detail::record(detail::statsFor<T>(), Event::Allocation, size, pointer, site);
+    }
+}
+
+template<typename T>
+void onDeallocation(void const* pointer)
+{
+    if (detail::sampleAddress(pointer))
+    {
+        detail::recordDeallocation(detail::statsFor<T>(), pointer);
+    }
+}
+
+//For an object whose allocation was counted for stats, whatever its static type is now
+inline void onDeallocation(TypeStats* stats, void const* pointer)
+{
+    if (detail::sampleAddress(pointer))
+    {
+        detail::recordDeallocation(stats, pointer);
+    }
+}
+
+template<typename T>
+void onEvent(Event event, CallSite site = CallSite{nullptr, 0})
+{
+    if (detail::sampleEvent())
+    {
+        detail::record(detail::statsFor<T>(), event, 0, nullptr, site);
+    }
+}
+
+//Writes all the counters as one JSON object
+void dump(std::ostream& out);
+//Appends a dump to path every period, on a background thread, until stopPeriodicDump()
+void startPeriodicDump(std::string path, std::chrono::milliseconds period);
+void stopPeriodicDump();
+void setSamplingPeriod(unsigned period);
+void reset();
+
+template<typename T>
+Counts counts()
+{
+    return detail::counts(detail::statsFor<T>());
+}
+
+/*Counts the allocation of std::allocate_shared, that holds both the control block and the object.
+std::allocate_shared rebinds it to its own control block type, so Owner keeps the type to count it for.*/
+template<typename T, typename Owner = T>
+class TrackingAllocator
+{
+    public:
+        using value_type = T;
+
+        explicit TrackingAllocator(CallSite site) noexcept : site_(site) {}
+        template<typename U>
+        TrackingAllocator(const TrackingAllocator<U, Owner>& other) noexcept : site_(other.site_) {}
+
+        T* allocate(std::size_t n)
+        {
+            T* pointer = std::allocator<T>().allocate(n);
+            onAllocation<Owner>(pointer, n * sizeof(T), site_);
+            return pointer;
+        }
+
+        void deallocate(T* pointer, std::size_t n) noexcept
+        {
+            onDeallocation<Owner>(pointer);
+            std::allocator<T>().deallocate(pointer, n);
+        }
+
+        template<typename U>
+        bool operator==(const TrackingAllocator<U, Owner>&) const noexcept { return true; }
+        template<typename U>
+        bool operator!=(const TrackingAllocator<U, Owner>&) const noexcept { return false; }
+
+    private:
+        template<typename U, typename O>
+        friend class TrackingAllocator;
+        CallSite site_;
+};
+
+template<typename T, typename... Args>
+std::shared_ptr<T> makeSharedAt(CallSite site, Args&&... args)
+{
+    onEvent<T>(Event::ControlBlock, site);
+    return std::allocate_shared<T>(TrackingAllocator<T>(site), std::forward<Args>(args)...);
+}
+
+template<typename T, typename... Args>
+UniquePtr<T> makeUniqueAt(CallSite site, Args&&... args)
+{
+    T* pointer = new T(std::forward<Args>(args)...);
+    onAllocation<T>(pointer, sizeof(T), site);
+    return UniquePtr<T>(pointer, TrackingDelete<T>(detail::statsFor<T>()));
+}
+
+template<typename T>
+std::shared_ptr<T> lock(const std::weak_ptr<T>& weak, CallSite site = CallSite::current())
+{
+    std::shared_ptr<T> shared = weak.lock();
+    onEvent<T>(shared ? Event::WeakLock : Event::WeakLockFailure, site);
+    return shared;
+}
+#else
+constexpr bool enabled = false;
+
+struct CallSite
+{
+    static constexpr CallSite current() noexcept { return CallSite{}; }
+};
+
+template<typename T>
+void onAllocation(void const*, std::size_t, CallSite = CallSite{}) noexcept {}
+template<typename T>
+void onDeallocation(void const*) noexcept {}
+template<typename T>
+void onEvent(Event, CallSite = CallSite{}) noexcept {}
+
+void dump(std::ostream& out);
+inline void startPeriodicDump(std::string, std::chrono::milliseconds) {}
+inline void stopPeriodicDump() {}
+inline void setSamplingPeriod(unsigned) noexcept {}
+inline void reset() noexcept {}
+
+template<typename T>
+Counts counts() noexcept
+{
+    return Counts{};
+}
+
+template<typename T, typename... Args>
+std::shared_ptr<T> makeSharedAt(CallSite, Args&&... args)
+{
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+template<typename T, typename... Args>
+UniquePtr<T> makeUniqueAt(CallSite, Args&&... args)
+{
+    return UniquePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+template<typename T>
+std::shared_ptr<T> lock(const std::weak_ptr<T>& weak, CallSite = CallSite{}) noexcept
+{
+    return weak.lock();
+}
+#endif
+
+#ifdef SMARTPOINTERS_INSTRUMENTATION
+/*Holds the counters of the allocated type, that makeUnique passes. One that is default constructed,
+for a pointer adopted without makeUnique, counts the deallocation for T.*/
+template<typename T>
+struct TrackingDelete
+{
+    TrackingDelete() noexcept = default;
+    explicit TrackingDelete(TypeStats* stats) noexcept : stats(stats) {}
+
+    //Like std::default_delete, so that UniquePtr<Derived> converts to UniquePtr<Base>
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+    TrackingDelete(const TrackingDelete<U>& other) noexcept : stats(other.stats ? other.stats : detail::statsFor<U>()) {}
+
+    void operator()(T* pointer) const
+    {
+        onDeallocation(stats ? stats : detail::statsFor<T>(), pointer);
+        delete pointer;
+    }
+
+    TypeStats* stats = nullptr;
+};
+#else
+//An empty class, so that UniquePtr is a single pointer
+template<typename T>
+struct TrackingDelete
+{
+    TrackingDelete() noexcept = default;
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+    TrackingDelete(const TrackingDelete<U>&) noexcept {}
+
+    void operator()(T* pointer) const
+    {
+        delete pointer;
+    }
+};
+
+static_assert(sizeof(UniquePtr<int>) == sizeof(int*), "TrackingDelete must not take any room");
+#endif
+
+//A parameter pack can't be followed by a default argument: these have no call site
+template<typename T, typename... Args>
+std::shared_ptr<T> makeShared(Args&&... args)
+{
+    return makeSharedAt<T>(CallSite{}, std::forward<Args>(args)...);
+}
+
+template<typename T, typename... Args>
+UniquePtr<T> makeUnique(Args&&... args)
+{
+    return makeUniqueAt<T>(CallSite{}, std::forward<Args>(args)...);
+}
+}
+}
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,338 @@
+#ifndef INTRUSIVEPTR_H
+#define INTRUSIVEPTR_H
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+/*std::shared_ptr keeps its reference count in a control block next to the object (with
+std::make_shared) or in a separate allocation (with shared_ptr(new T)), and every copy increments
+it atomically, even when the object never leaves its thread. An intrusive pointer keeps the count
+inside the object itself, by making it derive from RefCounted. The pointer is then a single raw
+pointer, and the thread safety of the count is chosen per type with a policy:
+    SingleThreaded : plain integer, for objects that stay in one thread
+    MultiThreaded : std::atomic, like std::shared_ptr*/
+
+/*The weak companion, IntrusiveWeakPtr, can break cycles like the House/neighbour one of main.cpp:
+struct House : util::RefCounted<util::SingleThreaded>
+{
+    util::IntrusiveWeakPtr<House> neighbour;
+};
+auto house1 = util::makeIntrusive<House>();
+auto house2 = util::makeIntrusive<House>();
+house1->neighbour = house2;
+house2->neighbour = house1;
+A weak pointer needs to know whether the object is still alive after the object is gone, so it
+can't look at a count inside the object. The first IntrusiveWeakPtr to an object therefore creates
+a small WeakProxy that the object marks as dead when it is destroyed. Objects that never have weak
+pointers don't pay for it.*/
+
+namespace util
+{
+class SingleThreaded
+{
+    public:
+        class Count
+        {
+            public:
+                explicit Count(long value) noexcept : value_(value) {}
+                void increment() noexcept { ++value_; }
+                //Returns true when the count reaches zero
+                bool decrement() noexcept { return --value_ == 0; }
+                bool incrementIfNotZero() noexcept
+                {
+                    if (value_ == 0)
+                    {
+                        return false;
+                    }
+                    ++value_;
+                    return true;
+                }
+                long get() const noexcept { return value_; }
+            private:
+                long value_;
+        };
+
+        class Mutex
+        {
+            public:
+                void lock() noexcept {}
+                void unlock() noexcept {}
+        };
+};
+
+class MultiThreaded
+{
+    public:
+        class Count
+        {
+            public:
+                explicit Count(long value) noexcept : value_(value) {}
+                void increment() noexcept { value_.fetch_add(1, std::memory_order_relaxed); }
+                bool decrement() noexcept { return value_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+                bool incrementIfNotZero() noexcept
+                {
+                    long value = value_.load(std::memory_order_relaxed);
+                    while (value != 0)
+                    {
+                        if (value_.compare_exchange_weak(value, value + 1, std::memory_order_relaxed))
+                        {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+                long get() const noexcept { return value_.load(std::memory_order_relaxed); }
+            private:
+                std::atomic<long> value_;
+        };
+
+        //IntrusiveWeakPtr::lock() only holds it for a few instructions, so a spin lock is enough
+        class Mutex
+        {
+            public:
+                void lock() noexcept
+                {
+                    while (flag_.test_and_set(std::memory_order_acquire))
+                    {
+                    }
+                }
+                void unlock() noexcept { flag_.clear(std::memory_order_release); }
+            private:
+                std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+        };
+};
+
+template<typename T>
+class IntrusivePtr;
+template<typename T>
+class IntrusiveWeakPtr;
+
+template<typename ThreadingPolicy>
+class RefCounted
+{
+    public:
+        long useCount() const noexcept { return count_.get(); }
+
+    protected:
+        RefCounted() noexcept = default;
+        //A copy of the object is a new object, nobody points to it yet
+        RefCounted(const RefCounted&) noexcept {}
+        RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+
+        ~RefCounted()
+        {
+            WeakProxy* proxy = proxy_.load(std::memory_order_acquire);
+            if (proxy && proxy->weakCount.decrement())
+            {
+                delete proxy;
+            }
+        }
+
+    private:
+        template<typename T>
+        friend class IntrusivePtr;
+        template<typename T>
+        friend class IntrusiveWeakPtr;
+
+        struct WeakProxy
+        {
+            //One reference for the object itself, plus one per IntrusiveWeakPtr
+            typename ThreadingPolicy::Count weakCount{1};
+            typename ThreadingPolicy::Mutex mutex;
+            bool alive = true;
+        };
+
+        void addRef() const noexcept { count_.increment(); }
+
+        //Returns true when the caller released the last reference and has to delete the object
+        bool releaseRef() const noexcept
+        {
+            if (!count_.decrement())
+            {
+                return false;
+            }
+            if (WeakProxy* proxy = proxy_.load(std::memory_order_acquire))
+            {
+                std::lock_guard<typename ThreadingPolicy::Mutex> guard(proxy->mutex);
+                proxy->alive = false;
+            }
+            return true;
+        }
+
+        WeakProxy* weakProxy() const
+        {
+            WeakProxy* proxy = proxy_.load(std::memory_order_acquire);
+            if (!proxy)
+            {
+                WeakProxy* created = new WeakProxy;
+                if (proxy_.compare_exchange_strong(proxy, created, std::memory_order_acq_rel))
+                {
+                    proxy = created;
+                }
+                else
+                {
+                    delete created;
+                }
+            }
+            return proxy;
+        }
+
+        mutable typename ThreadingPolicy::Count count_{0};
+        mutable std::atomic<WeakProxy*> proxy_{nullptr};
+};
+
+template<typename T>
+class IntrusivePtr
+{
+    public:
+        IntrusivePtr() noexcept = default;
+        IntrusivePtr(std::nullptr_t) noexcept {}
+
+        //Takes a reference on pointer: the count is in the object, so this is safe even if
+        //other IntrusivePtrs already point to it, unlike shared_ptr(new T) twice
+        explicit IntrusivePtr(T* pointer) noexcept : pointer_(pointer)
+        {
+            if (pointer_)
+            {
+                pointer_->addRef();
+            }
+        }
+
+        IntrusivePtr(const IntrusivePtr& other) noexcept : IntrusivePtr(other.pointer_) {}
+        IntrusivePtr(IntrusivePtr&& other) noexcept : pointer_(other.pointer_) { other.pointer_ = nullptr; }
+
+        template<typename U>
+        IntrusivePtr(const IntrusivePtr<U>& other) noexcept : IntrusivePtr(other.get()) {}
+        template<typename U>
+        IntrusivePtr(IntrusivePtr<U>&& other) noexcept : pointer_(other.release()) {}
+
+        ~IntrusivePtr()
+        {
+            if (pointer_ && pointer_->releaseRef())
+            {
+                delete pointer_;
+            }
+        }
+
+        IntrusivePtr& operator=(IntrusivePtr other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+
+        void reset() noexcept { IntrusivePtr().swap(*this); }
+        void swap(IntrusivePtr& other) noexcept { std::swap(pointer_, other.pointer_); }
+
+        //Gives up the reference without releasing it
+        T* release() noexcept
+        {
+            T* pointer = pointer_;
+            pointer_ = nullptr;
+            return pointer;
+        }
+
+        T* get() const noexcept { return pointer_; }
+        T& operator*() const noexcept { return *pointer_; }
+        T* operator->() const noexcept { return pointer_; }
+        explicit operator bool() const noexcept { return pointer_ != nullptr; }
+
+    private:
+        template<typename U>
+        friend class IntrusiveWeakPtr;
+
+        struct Adopt {};
+        IntrusivePtr(T* pointer, Adopt) noexcept : pointer_(pointer) {}
+
+        T* pointer_ = nullptr;
+};
+
+template<typename T, typename U>
+bool operator==(const IntrusivePtr<T>& p1, const IntrusivePtr<U>& p2) noexcept { return p1.get() == p2.get(); }
+template<typename T, typename U>
+bool operator!=(const IntrusivePtr<T>& p1, const IntrusivePtr<U>& p2) noexcept { return p1.get() != p2.get(); }
+
+template<typename T, typename... Args>
+IntrusivePtr<T> makeIntrusive(Args&&... args)
+{
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+template<typename T>
+class IntrusiveWeakPtr
+{
+    public:
+        IntrusiveWeakPtr() noexcept = default;
+
+        template<typename U>
+        IntrusiveWeakPtr(const IntrusivePtr<U>& strong) : pointer_(strong.get())
+        {
+            if (pointer_)
+            {
+                auto* proxy = pointer_->weakProxy();
+                proxy->weakCount.increment();
+                proxy_ = proxy;
+            }
+        }
+
+        IntrusiveWeakPtr(const IntrusiveWeakPtr& other) noexcept : pointer_(other.pointer_), proxy_(other.proxy_)
+        {
+            if (proxy_)
+            {
+                proxy()->weakCount.increment();
+            }
+        }
+
+        IntrusiveWeakPtr(IntrusiveWeakPtr&& other) noexcept : pointer_(other.pointer_), proxy_(other.proxy_)
+        {
+            other.pointer_ = nullptr;
+            other.proxy_ = nullptr;
+        }
+
+        ~IntrusiveWeakPtr()
+        {
+            if (proxy_ && proxy()->weakCount.decrement())
+            {
+                delete proxy();
+            }
+        }
+
+        IntrusiveWeakPtr& operator=(IntrusiveWeakPtr other) noexcept
+        {
+            std::swap(pointer_, other.pointer_);
+            std::swap(proxy_, other.proxy_);
+            return *this;
+        }
+
+        //Like std::weak_ptr::lock(): an empty IntrusivePtr if the object is no longer here
+        IntrusivePtr<T> lock() const noexcept
+        {
+            if (!proxy_)
+            {
+                return IntrusivePtr<T>();
+            }
+            auto* proxy = this->proxy();
+            std::lock_guard<decltype(proxy->mutex)> guard(proxy->mutex);
+            if (proxy->alive && pointer_->count_.incrementIfNotZero())
+            {
+                return IntrusivePtr<T>(pointer_, typename IntrusivePtr<T>::Adopt());
+            }
+            return IntrusivePtr<T>();
+        }
+
+        bool expired() const noexcept { return !lock(); }
+
+    private:
+        /*The type of the proxy depends on the threading policy of T, and T is often still incomplete
+        here (a House holding an IntrusiveWeakPtr<House>), so the proxy is only typed when used.*/
+        auto proxy() const noexcept
+        {
+            return static_cast<decltype(pointer_->weakProxy())>(proxy_);
+        }
+
+        T* pointer_ = nullptr;
+        void* proxy_ = nullptr;
+};
+}
+
+#endif // INTRUSIVEPTR_H
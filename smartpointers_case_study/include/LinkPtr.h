@@ -0,0 +1,153 @@
+#ifndef LINKPTR_H
+#define LINKPTR_H
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "Arena.h"
+#include "DeleterTraits.h"
+
+/*A structure linked with unique_ptrs, like a list where each House owns its neighbour, is destroyed
+recursively: the destructor of the first node destroys its unique_ptr, which runs the destructor
+of the second node, and so on. The stack grows by a frame per node, so a chain of a few hundred
+thousand nodes overflows it, and a deep tree pays a nested call per level.*/
+
+/*LinkPtr is a unique_ptr for the links of such structures. When it deletes its node, the LinkPtrs
+inside the node don't delete theirs: they hand them over to a worklist of the thread, and the
+outermost LinkPtr deletes the nodes of the worklist one after the other, in a loop. The stack
+stays at a single node destructor whatever the depth, and the worklist holds one node for a chain,
+and the pending subtrees for a tree. No node has to list its children: any LinkPtr member works,
+in a std::vector too.
+struct House
+{
+    util::LinkPtr<House> neighbour;
+};
+A child is deleted after its parent rather than during its destructor, so a destructor can't use
+its children once its own body is done (it can't with unique_ptrs either).*/
+
+/*The deleter is TraitsDeleter<T> by default (a delete, or whatever DeleterTraits<T> says), or any
+other empty deleter. With an ArenaDeleter, the nodes come from an Arena and go back to it one by
+one; if they own nothing outside of the arena, root.release() followed by arena.reset() frees the
+whole structure at once, without visiting it.*/
+
+namespace util
+{
+namespace detail
+{
+struct PendingLink
+{
+    void* object;
+    void* context;
+    void (*dispose)(void* object, void* context);
+};
+
+//Disposes of link, and of all the links that its destruction hands over, without recursion
+void disposeLink(PendingLink link) noexcept;
+
+template<typename T, typename Deleter>
+struct LinkDisposal
+{
+    static_assert(std::is_empty<Deleter>::value && std::is_default_constructible<Deleter>::value,
+                  "LinkPtr: the deleter must be an empty class, or an ArenaDeleter");
+
+    static void* context(const Deleter&) noexcept { return nullptr; }
+
+    static void dispose(void* object, void*)
+    {
+        Deleter()(static_cast<T*>(object));
+    }
+};
+
+template<typename T, typename U>
+struct LinkDisposal<T, ArenaDeleter<U>>
+{
+    static void* context(const ArenaDeleter<U>& deleter) noexcept { return deleter.arena(); }
+
+    static void dispose(void* object, void* arena)
+    {
+        static_cast<Arena*>(arena)->destroy(static_cast<T*>(object));
+    }
+};
+}
+
+template<typename T, typename Deleter = TraitsDeleter<T>>
+class LinkPtr
+{
+    public:
+        using pointer = T*;
+        using element_type = T;
+        using deleter_type = Deleter;
+
+        LinkPtr() noexcept = default;
+        LinkPtr(std::nullptr_t) noexcept {}
+        explicit LinkPtr(T* pointer) noexcept : pointer_(pointer) {}
+        LinkPtr(T* pointer, const Deleter& deleter) noexcept : pointer_(pointer, deleter) {}
+        LinkPtr(LinkPtr&& other) noexcept = default;
+
+        template<typename U, typename E, typename = std::enable_if_t<std::is_convertible<U*, T*>::value && std::is_convertible<E, Deleter>::value>>
+        LinkPtr(LinkPtr<U, E>&& other) noexcept : pointer_(other.release(), std::move(other.get_deleter()))
+        {
+        }
+
+        LinkPtr(const LinkPtr&) = delete;
+        LinkPtr& operator=(const LinkPtr&) = delete;
+
+        LinkPtr& operator=(LinkPtr&& other) noexcept
+        {
+            LinkPtr(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        LinkPtr& operator=(std::nullptr_t) noexcept
+        {
+            reset();
+            return *this;
+        }
+
+        ~LinkPtr()
+        {
+            if (T* const object = pointer_.release())
+            {
+                detail::disposeLink({object, Disposal::context(get_deleter()), &Disposal::dispose});
+            }
+        }
+
+        T* get() const noexcept { return pointer_.get(); }
+        T& operator*() const noexcept { return *get(); }
+        T* operator->() const noexcept { return get(); }
+        explicit operator bool() const noexcept { return get() != nullptr; }
+
+        Deleter& get_deleter() noexcept { return pointer_.get_deleter(); }
+        const Deleter& get_deleter() const noexcept { return pointer_.get_deleter(); }
+
+        T* release() noexcept { return pointer_.release(); }
+
+        //Also safe for the classic pop of a list, head = std::move(head->next)
+        void reset(T* pointer = nullptr) noexcept
+        {
+            LinkPtr(pointer, get_deleter()).swap(*this);
+        }
+
+        void swap(LinkPtr& other) noexcept { pointer_.swap(other.pointer_); }
+
+    private:
+        using Disposal = detail::LinkDisposal<T, Deleter>;
+
+        //Only for the storage: an empty deleter takes no space
+        std::unique_ptr<T, Deleter> pointer_;
+};
+
+template<typename T, typename... Args>
+LinkPtr<T> makeLink(Args&&... args)
+{
+    return LinkPtr<T>(new T(std::forward<Args>(args)...));
+}
+
+template<typename T, typename... Args>
+LinkPtr<T, ArenaDeleter<T>> makeArenaLink(Arena& arena, Args&&... args)
+{
+    return LinkPtr<T, ArenaDeleter<T>>(arena.create<T>(std::forward<Args>(args)...), ArenaDeleter<T>(arena));
+}
+}
+
+#endif // LINKPTR_H
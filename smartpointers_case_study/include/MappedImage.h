@@ -0,0 +1,139 @@
+#ifndef MAPPEDIMAGE_H
+#define MAPPEDIMAGE_H
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "OffsetPtr.h"
+
+/*An image is a file that holds an object graph exactly as it is in memory, with OffsetPtrs and
+OffsetArrays for the edges. Opening it is a single mmap: no parsing, no allocation per node, and
+the pages are only read from the file when the graph gets to them.*/
+
+/*ImageWriter builds the graph in a block of address space that it reserves up front, so that the
+objects never move while they are linked, then save() writes the block to a file. The usual way
+to persist a graph of unique_ptrs or shared_ptrs is a recursive copy into image nodes:
+Node* persist(util::ImageWriter& writer, const Tree& tree)
+{
+    if (Node* copy = writer.find<Node>(&tree))
+    {
+        return copy; //A node shared by several shared_ptrs is written once
+    }
+    Node* node = writer.create<Node>(tree.value);
+    writer.remember(&tree, node); //Before the children, whose back-edges point to it
+    node->children = writer.createArray<util::OffsetPtr<Node>>(tree.children.size());
+    for (std::size_t i = 0; i < tree.children.size(); ++i)
+    {
+        node->children[i] = persist(writer, *tree.children[i]);
+    }
+    return node;
+}
+writer.save("graph.image", persist(writer, tree));
+...
+util::MappedImage image("graph.image");
+Node* root = image.root<Node>();*/
+
+/*The nodes must be trivially destructible, since nothing destroys them, and not polymorphic,
+since a vtable pointer is an address of the process that wrote it. An image is only portable
+between builds that lay the nodes out the same way: the header checks the byte order, and the
+rest is up to the types.*/
+
+namespace util
+{
+class ImageWriter
+{
+    public:
+        //capacity only reserves address space: the memory is used as the image grows
+        explicit ImageWriter(std::size_t capacity = std::size_t(1) << 30);
+        ~ImageWriter();
+        ImageWriter(const ImageWriter&) = delete;
+        ImageWriter& operator=(const ImageWriter&) = delete;
+
+        //Throws std::bad_alloc when the image would outgrow its capacity
+        void* allocate(std::size_t size, std::size_t alignment);
+
+        template<typename T, typename... Args>
+        T* create(Args&&... args)
+        {
+            checkPersistable<T>();
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template<typename T>
+        OffsetArray<T> createArray(std::size_t count)
+        {
+            checkPersistable<T>();
+            T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                new (data + i) T();
+            }
+            return OffsetArray<T>(data, count);
+        }
+
+        //The copy of source recorded by remember(), or null
+        template<typename T>
+        T* find(const void* source) const
+        {
+            auto const copy = copies_.find(source);
+            return copy == copies_.end() ? nullptr : static_cast<T*>(copy->second);
+        }
+
+        void remember(const void* source, void* copy) { copies_[source] = copy; }
+
+        //Writes the image, whose root is root, to path. Throws std::system_error if it can't
+        template<typename T>
+        void save(const std::string& path, const T* root) const
+        {
+            save(path, root, sizeof(T), alignof(T));
+        }
+
+        std::size_t size() const noexcept { return used_; }
+
+    private:
+        template<typename T>
+        static void checkPersistable()
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "ImageWriter: nothing destroys the objects of an image");
+            static_assert(!std::is_polymorphic<T>::value, "ImageWriter: a vtable pointer doesn't survive in a file");
+        }
+
+        void save(const std::string& path, const void* root, std::size_t rootSize, std::size_t rootAlignment) const;
+
+        char* base_;
+        std::size_t capacity_;
+        std::size_t used_;
+        std::unordered_map<const void*, void*> copies_;
+};
+
+//A saved image, mapped copy-on-write: changes to the graph stay in the process, never in the file
+class MappedImage
+{
+    public:
+        //Throws std::system_error if path can't be mapped, std::runtime_error if it isn't a valid image
+        explicit MappedImage(const std::string& path);
+        ~MappedImage();
+        MappedImage(const MappedImage&) = delete;
+        MappedImage& operator=(const MappedImage&) = delete;
+
+        //T must be the type given to save(): the header only checks its size and alignment
+        template<typename T>
+        T* root() const
+        {
+            return static_cast<T*>(root(sizeof(T), alignof(T)));
+        }
+
+        std::size_t size() const noexcept { return size_; }
+
+    private:
+        void* root(std::size_t rootSize, std::size_t rootAlignment) const;
+
+        char* base_;
+        std::size_t size_;
+};
+}
+
+#endif // MAPPEDIMAGE_H
@@ -0,0 +1,99 @@
+#ifndef OFFSETPTR_H
+#define OFFSETPTR_H
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/*A unique_ptr or a shared_ptr holds an address, which only means something in the process that
+allocated it: a graph of them can't be written to a file and used again as is, it has to be
+rebuilt node by node at startup.*/
+
+/*OffsetPtr stores the distance from itself to its target instead. As long as the target moves with
+it, in the same block of memory, the pointer stays valid wherever the block ends up: in another
+process, or mapped from a file at another address (see MappedImage.h). It doesn't own anything:
+in such a block, the block owns all the objects, and a shared_ptr edge or a weak_ptr back-edge of
+the original graph both become an OffsetPtr. Copying an OffsetPtr recomputes the distance from
+the copy, so it may be copied anywhere, but it only survives a move of the block if it is inside
+the block too.*/
+
+namespace util
+{
+template<typename T>
+class OffsetPtr
+{
+    public:
+        using element_type = T;
+
+        OffsetPtr() noexcept = default;
+        OffsetPtr(std::nullptr_t) noexcept {}
+        OffsetPtr(T* pointer) noexcept { set(pointer); }
+        OffsetPtr(const OffsetPtr& other) noexcept { set(other.get()); }
+
+        OffsetPtr& operator=(const OffsetPtr& other) noexcept
+        {
+            set(other.get());
+            return *this;
+        }
+
+        OffsetPtr& operator=(T* pointer) noexcept
+        {
+            set(pointer);
+            return *this;
+        }
+
+        T* get() const noexcept
+        {
+            return offset_ == null ? nullptr : reinterpret_cast<T*>(reinterpret_cast<std::intptr_t>(this) + offset_);
+        }
+
+        T& operator*() const noexcept { return *get(); }
+        T* operator->() const noexcept { return get(); }
+        T& operator[](std::size_t index) const noexcept { return get()[index]; }
+        explicit operator bool() const noexcept { return offset_ != null; }
+
+    private:
+        /*0 would be a pointer to itself, which is just as unlikely, but 1 can't be the address of
+        any T that doesn't overlap the OffsetPtr (the null of boost::interprocess::offset_ptr)*/
+        static constexpr std::int64_t null = 1;
+
+        void set(T* pointer) noexcept
+        {
+            offset_ = pointer ? reinterpret_cast<std::intptr_t>(pointer) - reinterpret_cast<std::intptr_t>(this) : null;
+        }
+
+        //64 bits whatever the platform, so that the layout of an image doesn't depend on it
+        std::int64_t offset_ = null;
+};
+
+template<typename T>
+constexpr std::int64_t OffsetPtr<T>::null;
+
+template<typename T>
+bool operator==(const OffsetPtr<T>& p1, const OffsetPtr<T>& p2) noexcept { return p1.get() == p2.get(); }
+template<typename T>
+bool operator!=(const OffsetPtr<T>& p1, const OffsetPtr<T>& p2) noexcept { return p1.get() != p2.get(); }
+
+//A counted array in the same block, the relocatable std::vector of a node's children
+template<typename T>
+class OffsetArray
+{
+    public:
+        using value_type = T;
+        using iterator = T*;
+
+        OffsetArray() noexcept = default;
+        OffsetArray(T* data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+        T* begin() const noexcept { return data_.get(); }
+        T* end() const noexcept { return data_.get() + size_; }
+        T& operator[](std::size_t index) const noexcept { return data_[index]; }
+        std::size_t size() const noexcept { return static_cast<std::size_t>(size_); }
+        bool empty() const noexcept { return size_ == 0; }
+
+    private:
+        OffsetPtr<T> data_;
+        std::uint64_t size_ = 0;
+};
+}
+
+#endif // OFFSETPTR_H
@@ -0,0 +1,291 @@
+#ifndef POLYMORPHICCOLLECTION_H
+#define POLYMORPHICCOLLECTION_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "SlotMap.h"
+
+/*The move semantics section of main.cpp keeps its objects in a std::vector<std::unique_ptr<Base>>.
+Every Derived is a separate heap allocation, so a loop over the vector goes from pointer to pointer
+across the heap, and every call is a virtual call the compiler can't see through.*/
+
+/*PolymorphicCollection<Base> stores the objects by value instead, with one contiguous segment
+(a SlotMap<Derived>, whose objects are in a std::vector<Derived>) per concrete type:
+util::PolymorphicCollection<Instructions> instructions;
+auto handle = instructions.insert(Blueprint());
+instructions.forEach([](Instructions& i) { i.build(); });  // segment after segment, still virtual
+instructions.forEach<Blueprint>([](Blueprint& b) { b.build(); });  // one type, can be inlined
+instructions.erase(handle);
+Erasing moves the last object of the segment into the hole, so the order within a segment is not
+kept, and pointers and references to the objects are invalidated by insert and erase like in a
+std::vector. Handles are generational like SlotHandles: they stay valid until their own object is
+erased, and after that get() returns nullptr instead of another object that took the same place.
+They also remember their segment, so that the one created after clear() or after moveSegmentTo()
+doesn't take them for its own.*/
+
+namespace util
+{
+template<typename Base>
+class PolymorphicCollection
+{
+    public:
+        //Designates one object of type Derived, whatever happens to the other objects
+        template<typename Derived>
+        struct Handle
+        {
+            SlotHandle slot;
+            std::uint64_t segment = 0;
+        };
+
+        PolymorphicCollection() = default;
+        PolymorphicCollection(PolymorphicCollection&&) = default;
+        PolymorphicCollection& operator=(PolymorphicCollection&&) = default;
+
+        template<typename Derived>
+        Handle<std::decay_t<Derived>> insert(Derived&& object)
+        {
+            return emplace<std::decay_t<Derived>>(std::forward<Derived>(object));
+        }
+
+        template<typename Derived, typename... Args>
+        Handle<Derived> emplace(Args&&... args)
+        {
+            Segment<Derived>& segment = this->segment<Derived>();
+            return Handle<Derived>{segment.objects.emplace(std::forward<Args>(args)...), segment.id};
+        }
+
+        //Returns false if the object had already been erased
+        template<typename Derived>
+        bool erase(Handle<Derived> handle)
+        {
+            Segment<Derived>* const segment = find<Derived>(handle);
+            return segment && segment->objects.erase(handle.slot);
+        }
+
+        //The object, or nullptr if it has been erased since the handle was given
+        template<typename Derived>
+        Derived* get(Handle<Derived> handle) noexcept
+        {
+            Segment<Derived>* const segment = find<Derived>(handle);
+            return segment ? segment->objects.get(handle.slot) : nullptr;
+        }
+
+        template<typename Derived>
+        const Derived* get(Handle<Derived> handle) const noexcept
+        {
+            const Segment<Derived>* const segment = find<Derived>(handle);
+            return segment ? segment->objects.get(handle.slot) : nullptr;
+        }
+
+        template<typename Derived>
+        bool contains(Handle<Derived> handle) const noexcept { return get(handle) != nullptr; }
+
+        //Throws std::out_of_range if the object has been erased
+        template<typename Derived>
+        Derived& operator[](Handle<Derived> handle)
+        {
+            return checked(get(handle));
+        }
+
+        template<typename Derived>
+        const Derived& operator[](Handle<Derived> handle) const
+        {
+            return checked(get(handle));
+        }
+
+        //All the objects, segment after segment, through a Base&
+        template<typename F>
+        void forEach(F&& f)
+        {
+            for (auto& segment : segments_)
+            {
+                Bases const bases = segment->bases();
+                for (std::size_t i = 0; i < bases.count; ++i)
+                {
+                    f(*reinterpret_cast<Base*>(bases.first + i * bases.stride));
+                }
+            }
+        }
+
+        /*The objects of one type, through a Derived&: the compiler knows the type, so calls to
+        final or non-virtual members can be inlined.*/
+        template<typename Derived, typename F>
+        void forEach(F&& f)
+        {
+            if (Segment<Derived>* const segment = find<Derived>())
+            {
+                for (Derived& object : segment->objects)
+                {
+                    f(object);
+                }
+            }
+        }
+
+        /*Moves all the objects of type Derived to destination. If destination has none yet, the
+        segment is handed over as is and the handles remain valid in destination. Otherwise its
+        objects are appended to the existing segment and get new handles there, while the old ones
+        expire.*/
+        template<typename Derived>
+        void moveSegmentTo(PolymorphicCollection& destination)
+        {
+            if (&destination == this)
+            {
+                return;
+            }
+            auto const it = index_.find(typeid(Derived));
+            if (it == index_.end())
+            {
+                return;
+            }
+            std::size_t const position = it->second;
+            std::unique_ptr<SegmentBase> moved = std::move(segments_[position]);
+            segments_.erase(segments_.begin() + position);
+            index_.erase(it);
+            for (auto& entry : index_)
+            {
+                if (entry.second > position)
+                {
+                    --entry.second;
+                }
+            }
+            if (Segment<Derived>* const existing = destination.find<Derived>())
+            {
+                for (Derived& object : static_cast<Segment<Derived>&>(*moved).objects)
+                {
+                    existing->objects.emplace(std::move(object));
+                }
+                return;
+            }
+            destination.index_.emplace(typeid(Derived), destination.segments_.size());
+            destination.segments_.push_back(std::move(moved));
+        }
+
+        template<typename Derived>
+        std::size_t size() const
+        {
+            const Segment<Derived>* const segment = find<Derived>();
+            return segment ? segment->objects.size() : 0;
+        }
+
+        std::size_t size() const
+        {
+            std::size_t size = 0;
+            for (auto const& segment : segments_)
+            {
+                size += segment->bases().count;
+            }
+            return size;
+        }
+
+        bool empty() const { return size() == 0; }
+
+        void clear()
+        {
+            segments_.clear();
+            index_.clear();
+        }
+
+    private:
+        //Where the Base subobjects are: the objects of a segment are all sizeof(Derived) apart
+        struct Bases
+        {
+            char* first;
+            std::size_t stride;
+            std::size_t count;
+        };
+
+        struct SegmentBase
+        {
+            SegmentBase() : id(++nextId()) {}
+            virtual ~SegmentBase() = default;
+            virtual Bases bases() = 0;
+
+            //Unique among the segments of all the collections, so 0 is never one
+            static std::atomic<std::uint64_t>& nextId()
+            {
+                static std::atomic<std::uint64_t> next{0};
+                return next;
+            }
+
+            std::uint64_t const id;
+        };
+
+        template<typename Derived>
+        struct Segment : SegmentBase
+        {
+            static_assert(std::is_base_of<Base, Derived>::value, "PolymorphicCollection: Derived must derive from Base");
+
+            Bases bases() override
+            {
+                if (objects.empty())
+                {
+                    return {nullptr, sizeof(Derived), 0};
+                }
+                return {reinterpret_cast<char*>(static_cast<Base*>(&*objects.begin())), sizeof(Derived), objects.size()};
+            }
+
+            SlotMap<Derived> objects;
+        };
+
+        template<typename Derived>
+        Segment<Derived>* find()
+        {
+            auto const it = index_.find(typeid(Derived));
+            return it == index_.end() ? nullptr : static_cast<Segment<Derived>*>(segments_[it->second].get());
+        }
+
+        template<typename Derived>
+        const Segment<Derived>* find() const
+        {
+            return const_cast<PolymorphicCollection*>(this)->find<Derived>();
+        }
+
+        //The segment of the handle, if it is still the segment of Derived in this collection
+        template<typename Derived>
+        Segment<Derived>* find(Handle<Derived> handle)
+        {
+            Segment<Derived>* const segment = find<Derived>();
+            return segment && segment->id == handle.segment ? segment : nullptr;
+        }
+
+        template<typename Derived>
+        const Segment<Derived>* find(Handle<Derived> handle) const
+        {
+            return const_cast<PolymorphicCollection*>(this)->find(handle);
+        }
+
+        template<typename Object>
+        static Object& checked(Object* object)
+        {
+            if (!object)
+            {
+                throw std::out_of_range("PolymorphicCollection: the object of the handle has been erased");
+            }
+            return *object;
+        }
+
+        template<typename Derived>
+        Segment<Derived>& segment()
+        {
+            if (Segment<Derived>* const existing = find<Derived>())
+            {
+                return *existing;
+            }
+            index_.emplace(typeid(Derived), segments_.size());
+            segments_.push_back(std::make_unique<Segment<Derived>>());
+            return static_cast<Segment<Derived>&>(*segments_.back());
+        }
+
+        std::vector<std::unique_ptr<SegmentBase>> segments_;
+        std::unordered_map<std::type_index, std::size_t> index_;
+};
+}
+
+#endif // POLYMORPHICCOLLECTION_H
@@ -0,0 +1,206 @@
+#ifndef POLYMORPHICVALUE_H
+#define POLYMORPHICVALUE_H
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*To deep copy a std::unique_ptr<Base>, main.cpp gives Base a virtual cloneBase() that every
+derived class has to override, and every copy is a new heap allocation, even for a House that
+copies its Instructions (a Sketch or a Blueprint).*/
+
+/*PolymorphicValue<Base> holds an object of any class derived from Base, with value semantics:
+copying it copies the derived object. The copy and move operations are generated from the copy
+and move constructors of the derived class when it is put in, so there is no cloneBase() to write.
+Objects that fit in BufferSize bytes (and can be moved without throwing) are stored inside the
+PolymorphicValue, the bigger ones on the heap:
+util::PolymorphicValue<Instructions> instructions = util::makePolymorphic<Instructions, Blueprint>();
+util::PolymorphicValue<Instructions> copy = instructions; // a new Blueprint, inline if it fits*/
+
+namespace util
+{
+template<typename Base, std::size_t BufferSize = 3 * sizeof(void*)>
+class PolymorphicValue
+{
+    public:
+        template<typename Derived, typename... Args>
+        static PolymorphicValue make(Args&&... args)
+        {
+            PolymorphicValue value;
+            value.template emplace<Derived>(std::forward<Args>(args)...);
+            return value;
+        }
+
+        template<typename Derived, typename = std::enable_if_t<!std::is_same<std::decay_t<Derived>, PolymorphicValue>::value>>
+        PolymorphicValue(Derived&& object)
+        {
+            emplace<std::decay_t<Derived>>(std::forward<Derived>(object));
+        }
+
+        PolymorphicValue(const PolymorphicValue& other)
+        {
+            if (other.operations_)
+            {
+                other.operations_->copy(other, *this);
+            }
+        }
+
+        PolymorphicValue(PolymorphicValue&& other) noexcept
+        {
+            if (other.operations_)
+            {
+                other.operations_->move(other, *this);
+            }
+        }
+
+        PolymorphicValue& operator=(const PolymorphicValue& other)
+        {
+            if (this != &other)
+            {
+                PolymorphicValue copy(other);
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+
+        PolymorphicValue& operator=(PolymorphicValue&& other) noexcept
+        {
+            if (this != &other)
+            {
+                clear();
+                if (other.operations_)
+                {
+                    other.operations_->move(other, *this);
+                }
+            }
+            return *this;
+        }
+
+        ~PolymorphicValue()
+        {
+            clear();
+        }
+
+        Base* get() noexcept { return base_; }
+        const Base* get() const noexcept { return base_; }
+        Base* operator->() noexcept { return base_; }
+        const Base* operator->() const noexcept { return base_; }
+        Base& operator*() noexcept { return *base_; }
+        const Base& operator*() const noexcept { return *base_; }
+        explicit operator bool() const noexcept { return base_ != nullptr; }
+
+        //True if the object is stored inside the PolymorphicValue
+        bool isInline() const noexcept { return base_ && operations_->inlined; }
+
+    private:
+        PolymorphicValue() noexcept = default;
+
+        //The "vtable" generated for each derived class
+        struct Operations
+        {
+            void (*copy)(const PolymorphicValue& from, PolymorphicValue& to);
+            void (*move)(PolymorphicValue& from, PolymorphicValue& to) noexcept;
+            void (*destroy)(PolymorphicValue& value) noexcept;
+            bool inlined;
+        };
+
+        template<typename Derived>
+        struct OperationsFor
+        {
+            using Inlined = std::integral_constant<bool, sizeof(Derived) <= BufferSize
+                                                         && alignof(Derived) <= alignof(std::max_align_t)
+                                                         && std::is_nothrow_move_constructible<Derived>::value>;
+
+            static Derived& object(const PolymorphicValue& value) noexcept
+            {
+                return *static_cast<Derived*>(value.base_);
+            }
+
+            template<typename... Args>
+            static Base* construct(PolymorphicValue& value, std::true_type, Args&&... args)
+            {
+                return ::new (&value.buffer_) Derived(std::forward<Args>(args)...);
+            }
+
+            template<typename... Args>
+            static Base* construct(PolymorphicValue&, std::false_type, Args&&... args)
+            {
+                return new Derived(std::forward<Args>(args)...);
+            }
+
+            static void copy(const PolymorphicValue& from, PolymorphicValue& to)
+            {
+                to.template emplace<Derived>(object(from));
+            }
+
+            static void move(PolymorphicValue& from, PolymorphicValue& to, std::true_type) noexcept
+            {
+                to.base_ = construct(to, std::true_type(), std::move(object(from)));
+                to.operations_ = from.operations_;
+                from.clear();
+            }
+
+            //A heap object just changes owner
+            static void move(PolymorphicValue& from, PolymorphicValue& to, std::false_type) noexcept
+            {
+                std::swap(to.base_, from.base_);
+                std::swap(to.operations_, from.operations_);
+            }
+
+            static void move(PolymorphicValue& from, PolymorphicValue& to) noexcept
+            {
+                move(from, to, Inlined());
+            }
+
+            static void destroy(PolymorphicValue& value) noexcept
+            {
+                if (Inlined::value)
+                {
+                    object(value).~Derived();
+                }
+                else
+                {
+                    delete &object(value);
+                }
+            }
+
+            static constexpr Operations table{&copy, &move, &destroy, Inlined::value};
+        };
+
+        template<typename Derived, typename... Args>
+        void emplace(Args&&... args)
+        {
+            static_assert(std::is_base_of<Base, Derived>::value, "PolymorphicValue: Derived must derive from Base");
+            static_assert(std::is_copy_constructible<Derived>::value, "PolymorphicValue: Derived must be copyable");
+            using Operations = OperationsFor<Derived>;
+            base_ = Operations::construct(*this, typename Operations::Inlined(), std::forward<Args>(args)...);
+            operations_ = &Operations::table;
+        }
+
+        void clear() noexcept
+        {
+            if (operations_)
+            {
+                operations_->destroy(*this);
+                base_ = nullptr;
+                operations_ = nullptr;
+            }
+        }
+
+        Base* base_ = nullptr;
+        const Operations* operations_ = nullptr;
+        std::aligned_storage_t<BufferSize, alignof(std::max_align_t)> buffer_;
+};
+
+template<typename Base, std::size_t BufferSize>
+template<typename Derived>
+constexpr typename PolymorphicValue<Base, BufferSize>::Operations PolymorphicValue<Base, BufferSize>::OperationsFor<Derived>::table;
+
+template<typename Base, typename Derived, typename... Args>
+PolymorphicValue<Base> makePolymorphic(Args&&... args)
+{
+    return PolymorphicValue<Base>::template make<Derived>(std::forward<Args>(args)...);
+}
+}
+
+#endif // POLYMORPHICVALUE_H
@@ -0,0 +1,265 @@
+#ifndef SLOTMAP_H
+#define SLOTMAP_H
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*main.cpp represents the nodes of a graph as std::shared_ptrs, and breaks the cycles between two
+Houses with a std::weak_ptr. For a large graph, each node then costs a separate allocation plus a
+control block, every traversal of an edge copies a shared_ptr (two atomic operations), and any
+cycle that was not broken by hand leaks.*/
+
+/*SlotMap<T> owns all the nodes in one contiguous std::vector, and the edges are SlotHandles: 32
+bits split into an index in the slot table and a generation. Erasing a node bumps the generation
+of its slot, so get() of an old handle returns nullptr, the same way weak_ptr::lock() tells that
+the object has expired. A slot whose generation has gone all the way around is retired for good,
+so an old handle never designates a newer node. There are no reference counts, and cycles cost
+nothing since the SlotMap is the only owner:
+util::SlotMap<House> houses;
+util::SlotHandle house1 = houses.emplace();
+util::SlotHandle house2 = houses.emplace();
+houses[house1].neighbour = house2;
+houses[house2].neighbour = house1;
+if (House* neighbour = houses.get(houses[house1].neighbour)) { ... }*/
+
+namespace util
+{
+class SlotHandle
+{
+    public:
+        static constexpr std::uint32_t Null = std::numeric_limits<std::uint32_t>::max();
+
+        SlotHandle() noexcept = default;
+        explicit SlotHandle(std::uint32_t bits) noexcept : bits_(bits) {}
+
+        std::uint32_t bits() const noexcept { return bits_; }
+        explicit operator bool() const noexcept { return bits_ != Null; }
+        bool operator==(SlotHandle other) const noexcept { return bits_ == other.bits_; }
+        bool operator!=(SlotHandle other) const noexcept { return bits_ != other.bits_; }
+
+    private:
+        std::uint32_t bits_ = Null;
+};
+
+/*IndexBits sets the maximum number of slots (16M by default), the rest of the 32 bits is the
+generation. emplace() throws std::length_error when all the slots are taken.*/
+template<typename T, unsigned IndexBits = 24>
+class SlotMap
+{
+    static_assert(IndexBits > 0 && IndexBits < 32, "SlotMap: the generation needs at least one bit");
+
+    public:
+        using iterator = typename std::vector<T>::iterator;
+        using const_iterator = typename std::vector<T>::const_iterator;
+
+        static constexpr std::uint32_t MaxSlots = (std::uint32_t(1) << IndexBits) - 1;
+        static constexpr std::uint32_t MaxGeneration = (std::uint32_t(1) << (32 - IndexBits)) - 1;
+
+        template<typename... Args>
+        SlotHandle emplace(Args&&... args)
+        {
+            std::uint32_t index;
+            if (freeHead_ != None)
+            {
+                index = freeHead_;
+            }
+            else
+            {
+                if (slots_.size() >= MaxSlots)
+                {
+                    throw std::length_error("SlotMap: too many slots for IndexBits");
+                }
+                index = static_cast<std::uint32_t>(slots_.size());
+                slots_.push_back(Slot{None, 0});
+            }
+            values_.emplace_back(std::forward<Args>(args)...);
+            if (index == freeHead_)
+            {
+                freeHead_ = slots_[index].position;
+            }
+            slots_[index].position = static_cast<std::uint32_t>(values_.size() - 1);
+            indices_.push_back(index);
+            return handle(index);
+        }
+
+        SlotHandle insert(T value)
+        {
+            return emplace(std::move(value));
+        }
+
+        //Returns false if the handle had already expired
+        bool erase(SlotHandle handle)
+        {
+            std::uint32_t const index = live(handle);
+            if (index == None)
+            {
+                return false;
+            }
+            std::uint32_t const position = slots_[index].position;
+            std::uint32_t const last = static_cast<std::uint32_t>(values_.size() - 1);
+            if (position != last)
+            {
+                values_[position] = std::move(values_[last]);
+                indices_[position] = indices_[last];
+                slots_[indices_[position]].position = position;
+            }
+            values_.pop_back();
+            indices_.pop_back();
+            release(index);
+            return true;
+        }
+
+        //The object, or nullptr if it has been erased since the handle was given
+        T* get(SlotHandle handle) noexcept
+        {
+            std::uint32_t const index = live(handle);
+            return index == None ? nullptr : &values_[slots_[index].position];
+        }
+
+        const T* get(SlotHandle handle) const noexcept
+        {
+            return const_cast<SlotMap*>(this)->get(handle);
+        }
+
+        bool contains(SlotHandle handle) const noexcept { return live(handle) != None; }
+
+        //For handles known to be alive
+        T& operator[](SlotHandle handle) noexcept
+        {
+            assert(contains(handle) && "SlotMap: expired handle");
+            return values_[slots_[handle.bits() & MaxSlots].position];
+        }
+
+        const T& operator[](SlotHandle handle) const noexcept
+        {
+            assert(contains(handle) && "SlotMap: expired handle");
+            return values_[slots_[handle.bits() & MaxSlots].position];
+        }
+
+        //The handle of the object at a given place in the iteration order
+        SlotHandle handleAt(std::size_t position) const noexcept
+        {
+            return handle(indices_[position]);
+        }
+
+        /*Erases all the objects for which predicate(object) is true, in a single pass that keeps
+        the order of the others. Returns how many were erased.*/
+        template<typename Predicate>
+        std::size_t eraseIf(Predicate predicate)
+        {
+            std::size_t kept = 0;
+            for (std::size_t position = 0; position < values_.size(); ++position)
+            {
+                if (predicate(const_cast<const T&>(values_[position])))
+                {
+                    release(indices_[position]);
+                    continue;
+                }
+                if (kept != position)
+                {
+                    values_[kept] = std::move(values_[position]);
+                    indices_[kept] = indices_[position];
+                }
+                slots_[indices_[kept]].position = static_cast<std::uint32_t>(kept);
+                ++kept;
+            }
+            std::size_t const erased = values_.size() - kept;
+            values_.erase(values_.begin() + kept, values_.end());
+            indices_.resize(kept);
+            return erased;
+        }
+
+        /*Erasing moves the last object into the hole, so after many erasures the objects are no
+        longer in the order they were created in. compact() puts them back in slot order, which is
+        roughly creation order, and gives back the memory of the erased ones.*/
+        void compact()
+        {
+            std::vector<std::uint32_t> order(values_.size());
+            std::iota(order.begin(), order.end(), 0u);
+            std::sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) { return indices_[a] < indices_[b]; });
+            std::vector<T> values;
+            std::vector<std::uint32_t> indices;
+            values.reserve(values_.size());
+            indices.reserve(indices_.size());
+            for (std::uint32_t const position : order)
+            {
+                slots_[indices_[position]].position = static_cast<std::uint32_t>(values.size());
+                values.push_back(std::move(values_[position]));
+                indices.push_back(indices_[position]);
+            }
+            values_ = std::move(values);
+            indices_ = std::move(indices);
+        }
+
+        void reserve(std::size_t capacity)
+        {
+            values_.reserve(capacity);
+            indices_.reserve(capacity);
+            slots_.reserve(capacity);
+        }
+
+        //The objects are contiguous, in no particular order
+        iterator begin() noexcept { return values_.begin(); }
+        iterator end() noexcept { return values_.end(); }
+        const_iterator begin() const noexcept { return values_.begin(); }
+        const_iterator end() const noexcept { return values_.end(); }
+        std::size_t size() const noexcept { return values_.size(); }
+        bool empty() const noexcept { return values_.empty(); }
+
+    private:
+        static constexpr std::uint32_t None = std::numeric_limits<std::uint32_t>::max();
+
+        //position is the place of the object in values_, or the next free slot if there is none
+        struct Slot
+        {
+            std::uint32_t position;
+            std::uint32_t generation;
+        };
+
+        SlotHandle handle(std::uint32_t index) const noexcept
+        {
+            return SlotHandle(slots_[index].generation << IndexBits | index);
+        }
+
+        //The index of the slot if the handle is still alive, None otherwise
+        std::uint32_t live(SlotHandle handle) const noexcept
+        {
+            std::uint32_t const index = handle.bits() & MaxSlots;
+            /*Free slots have moved on to another generation than the one of their handles. Retired
+            slots keep the last one, since it can't be bumped any further, but have no object.*/
+            if (index >= slots_.size() || handle != this->handle(index) || slots_[index].position == None)
+            {
+                return None;
+            }
+            return index;
+        }
+
+        void release(std::uint32_t index) noexcept
+        {
+            Slot& slot = slots_[index];
+            slot.position = None;
+            if (slot.generation == MaxGeneration)
+            {
+                //Retired: reusing it would make the oldest handles alive again
+                return;
+            }
+            ++slot.generation;
+            slot.position = freeHead_;
+            freeHead_ = index;
+        }
+
+        std::vector<T> values_;
+        //The slot of each object, in the same order as values_
+        std::vector<std::uint32_t> indices_;
+        std::vector<Slot> slots_;
+        std::uint32_t freeHead_ = None;
+};
+}
+
+#endif // SLOTMAP_H
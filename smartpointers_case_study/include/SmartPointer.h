@@ -0,0 +1,371 @@
+#ifndef SMARTPOINTER_H
+#define SMARTPOINTER_H
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "Arena.h"
+#include "DeleterTraits.h"
+#include "IntrusivePtr.h"
+
+/*The SmartPointer<T> sketched at the top of main.cpp deletes its object twice once copied. The
+std and boost pointers each fix it with their own trade-off: scoped_ptr can't be copied nor moved,
+unique_ptr can only be moved, shared_ptr counts its copies, atomically, and a raw pointer doesn't
+own anything. SmartPointer makes each of those choices a policy of the same template:
+    OwnershipPolicy : ScopedOwnership, UniqueOwnership (the default), CountedOwnership<SingleThreaded>,
+                      CountedOwnership<MultiThreaded> or BorrowedOwnership
+    CheckingPolicy : NoChecking (the default), AssertChecking or ThrowChecking, on dereference
+    StoragePolicy : DefaultStorage (delete, or what DeleterTraits<T> says) or ArenaStorage
+The policies are base classes: those without state are empty and take no space, and an operation
+that a policy doesn't allow, like copying a UniqueOwnership pointer, doesn't compile. Only
+CountedOwnership adds a pointer to its count, and only ArenaStorage a pointer to its arena (see the
+static_asserts at the end). Call sites that name the pointer through an alias switch policy with
+the alias:
+using FridgePointer = util::SmartPointer<Fridge, util::CountedOwnership<util::SingleThreaded>>;
+FridgePointer fridge = util::makeSmart<Fridge, util::CountedOwnership<util::SingleThreaded>>();*/
+
+/*The count of CountedOwnership is allocated apart from the object, like in shared_ptr(new T): no
+weak pointers, no aliasing, no type-erased deleter, so it is a bare SingleThreaded or MultiThreaded
+count of IntrusivePtr.h.*/
+
+namespace util
+{
+class ScopedOwnership
+{
+    public:
+        static constexpr bool copyable = false;
+
+    protected:
+        ScopedOwnership() noexcept = default;
+        ScopedOwnership(const ScopedOwnership&) = delete;
+        ScopedOwnership(ScopedOwnership&&) = delete;
+
+        void acquire() noexcept {}
+        bool release() noexcept { return true; }
+        void swap(ScopedOwnership&) noexcept {}
+};
+
+class UniqueOwnership
+{
+    public:
+        static constexpr bool copyable = false;
+
+    protected:
+        UniqueOwnership() noexcept = default;
+        UniqueOwnership(const UniqueOwnership&) = delete;
+        UniqueOwnership(UniqueOwnership&&) noexcept = default;
+
+        void acquire() noexcept {}
+        bool release() noexcept { return true; }
+        void swap(UniqueOwnership&) noexcept {}
+};
+
+template<typename ThreadingPolicy>
+class CountedOwnership
+{
+    public:
+        static constexpr bool copyable = true;
+
+        long useCount() const noexcept { return count_ ? count_->get() : 0; }
+
+    protected:
+        CountedOwnership() noexcept = default;
+
+        CountedOwnership(const CountedOwnership& other) noexcept : count_(other.count_)
+        {
+            if (count_)
+            {
+                count_->increment();
+            }
+        }
+
+        CountedOwnership(CountedOwnership&& other) noexcept : count_(other.count_)
+        {
+            other.count_ = nullptr;
+        }
+
+        void acquire() { count_ = new Count(1); }
+
+        //Returns true when the last owner lets go of the object
+        bool release() noexcept
+        {
+            if (!count_->decrement())
+            {
+                return false;
+            }
+            delete count_;
+            return true;
+        }
+
+        void swap(CountedOwnership& other) noexcept { std::swap(count_, other.count_); }
+
+    private:
+        using Count = typename ThreadingPolicy::Count;
+
+        Count* count_ = nullptr;
+};
+
+//A raw pointer with the interface of the others: copies freely and never deletes
+class BorrowedOwnership
+{
+    public:
+        static constexpr bool copyable = true;
+
+    protected:
+        void acquire() noexcept {}
+        bool release() noexcept { return false; }
+        void swap(BorrowedOwnership&) noexcept {}
+};
+
+struct NoChecking
+{
+    template<typename T>
+    static void check(T*) noexcept
+    {
+    }
+};
+
+//Free in a release build, where NDEBUG removes the assert
+struct AssertChecking
+{
+    template<typename T>
+    static void check(T* pointer) noexcept
+    {
+        assert(pointer && "SmartPointer: dereferencing a null pointer");
+        (void)pointer;
+    }
+};
+
+class NullPointerError : public std::logic_error
+{
+    public:
+        NullPointerError() : std::logic_error("SmartPointer: dereferencing a null pointer") {}
+};
+
+struct ThrowChecking
+{
+    template<typename T>
+    static void check(T* pointer)
+    {
+        if (!pointer)
+        {
+            throw NullPointerError();
+        }
+    }
+};
+
+struct DefaultStorage
+{
+    //A pointer to Derived may become a pointer to Base, deleted through the virtual destructor
+    static constexpr bool convertible = true;
+
+    template<typename T>
+    class Storage
+    {
+        protected:
+            Storage() noexcept = default;
+            explicit Storage(T* pointer) noexcept : pointer_(pointer) {}
+            Storage(const Storage&) noexcept = default;
+            Storage(Storage&& other) noexcept : pointer_(other.pointer_) { other.pointer_ = nullptr; }
+
+            template<typename U>
+            Storage(const Storage<U>& other) noexcept : pointer_(other.pointer_) {}
+            template<typename U>
+            Storage(Storage<U>&& other) noexcept : pointer_(other.pointer_) { other.pointer_ = nullptr; }
+
+            T* pointer() const noexcept { return pointer_; }
+            void dispose() noexcept { TraitsDeleter<T>()(pointer_); }
+            void swap(Storage& other) noexcept { std::swap(pointer_, other.pointer_); }
+
+        private:
+            template<typename>
+            friend class Storage;
+
+            T* pointer_ = nullptr;
+    };
+};
+
+/*The object goes back to the arena it came from, like with ArenaDeleter. The arena recycles blocks
+by size, and a pointer to Base would give back sizeof(Base) bytes for a Derived: like ArenaDeleter,
+ArenaStorage doesn't convert.*/
+struct ArenaStorage
+{
+    static constexpr bool convertible = false;
+
+    template<typename T>
+    class Storage
+    {
+        protected:
+            Storage() noexcept = default;
+            Storage(T* pointer, Arena& arena) noexcept : pointer_(pointer), arena_(&arena) {}
+            Storage(const Storage&) noexcept = default;
+            Storage(Storage&& other) noexcept : pointer_(other.pointer_), arena_(other.arena_) { other.pointer_ = nullptr; }
+
+            T* pointer() const noexcept { return pointer_; }
+            void dispose() noexcept { arena_->destroy(pointer_); }
+
+            void swap(Storage& other) noexcept
+            {
+                std::swap(pointer_, other.pointer_);
+                std::swap(arena_, other.arena_);
+            }
+
+        public:
+            Arena* arena() const noexcept { return arena_; }
+
+        private:
+            T* pointer_ = nullptr;
+            Arena* arena_ = nullptr;
+    };
+};
+
+template<typename T, typename OwnershipPolicy = UniqueOwnership, typename CheckingPolicy = NoChecking, typename StoragePolicy = DefaultStorage>
+class SmartPointer : public StoragePolicy::template Storage<T>, public OwnershipPolicy
+{
+    private:
+        using Storage = typename StoragePolicy::template Storage<T>;
+
+    public:
+        using element_type = T;
+
+        SmartPointer() noexcept = default;
+        SmartPointer(std::nullptr_t) noexcept {}
+
+        //Takes ownership of pointer, and the arguments of the storage, like the Arena of ArenaStorage
+        template<typename... StorageArgs>
+        explicit SmartPointer(T* pointer, StorageArgs&&... storageArgs) : Storage(pointer, std::forward<StorageArgs>(storageArgs)...)
+        {
+            if (!pointer)
+            {
+                return;
+            }
+            try
+            {
+                OwnershipPolicy::acquire();
+            }
+            catch (...)
+            {
+                Storage::dispose();
+                throw;
+            }
+        }
+
+        //Deleted by the policies that don't allow them
+        SmartPointer(const SmartPointer&) = default;
+        SmartPointer(SmartPointer&&) = default;
+
+        /*Like std::unique_ptr<Base> from std::unique_ptr<Derived>, if the storage allows it. Not for
+        U = T: a deleted defaulted move constructor is ignored, and this one would take its place*/
+        template<typename U, typename = std::enable_if_t<!std::is_same<U, T>::value && std::is_convertible<U*, T*>::value && StoragePolicy::convertible>>
+        SmartPointer(SmartPointer<U, OwnershipPolicy, CheckingPolicy, StoragePolicy>&& other) noexcept
+            : Storage(std::move(other.storage())), OwnershipPolicy(std::move(other.ownership()))
+        {
+        }
+
+        template<typename U, typename = std::enable_if_t<!std::is_same<U, T>::value && std::is_convertible<U*, T*>::value && OwnershipPolicy::copyable && StoragePolicy::convertible>>
+        SmartPointer(const SmartPointer<U, OwnershipPolicy, CheckingPolicy, StoragePolicy>& other) noexcept
+            : Storage(other.storage()), OwnershipPolicy(other.ownership())
+        {
+        }
+
+        //Copy or move assignment, whichever the policy allows
+        SmartPointer& operator=(SmartPointer other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+
+        ~SmartPointer()
+        {
+            if (get() && OwnershipPolicy::release())
+            {
+                Storage::dispose();
+            }
+        }
+
+        T* get() const noexcept { return Storage::pointer(); }
+
+        T& operator*() const noexcept(noexcept(CheckingPolicy::check(std::declval<T*>())))
+        {
+            CheckingPolicy::check(get());
+            return *get();
+        }
+
+        T* operator->() const noexcept(noexcept(CheckingPolicy::check(std::declval<T*>())))
+        {
+            CheckingPolicy::check(get());
+            return get();
+        }
+
+        explicit operator bool() const noexcept { return get() != nullptr; }
+
+        void reset() noexcept { SmartPointer().swap(*this); }
+
+        void swap(SmartPointer& other) noexcept
+        {
+            Storage::swap(other);
+            OwnershipPolicy::swap(other);
+        }
+
+    private:
+        template<typename, typename, typename, typename>
+        friend class SmartPointer;
+
+        Storage& storage() noexcept { return *this; }
+        const Storage& storage() const noexcept { return *this; }
+        OwnershipPolicy& ownership() noexcept { return *this; }
+        const OwnershipPolicy& ownership() const noexcept { return *this; }
+};
+
+template<typename T, typename O, typename C, typename S>
+bool operator==(const SmartPointer<T, O, C, S>& p1, const SmartPointer<T, O, C, S>& p2) noexcept { return p1.get() == p2.get(); }
+template<typename T, typename O, typename C, typename S>
+bool operator!=(const SmartPointer<T, O, C, S>& p1, const SmartPointer<T, O, C, S>& p2) noexcept { return p1.get() != p2.get(); }
+
+template<typename T, typename OwnershipPolicy = UniqueOwnership, typename CheckingPolicy = NoChecking, typename... Args>
+SmartPointer<T, OwnershipPolicy, CheckingPolicy> makeSmart(Args&&... args)
+{
+    return SmartPointer<T, OwnershipPolicy, CheckingPolicy>(new T(std::forward<Args>(args)...));
+}
+
+template<typename T, typename OwnershipPolicy = UniqueOwnership, typename CheckingPolicy = NoChecking, typename... Args>
+SmartPointer<T, OwnershipPolicy, CheckingPolicy, ArenaStorage> makeArenaSmart(Arena& arena, Args&&... args)
+{
+    return SmartPointer<T, OwnershipPolicy, CheckingPolicy, ArenaStorage>(arena.create<T>(std::forward<Args>(args)...), arena);
+}
+
+namespace detail
+{
+//The layout of each combination: the state that its policies need, and nothing else
+static_assert(sizeof(SmartPointer<int, ScopedOwnership>) == sizeof(int*), "SmartPointer: ScopedOwnership takes no space");
+static_assert(sizeof(SmartPointer<int, UniqueOwnership, ThrowChecking>) == sizeof(std::unique_ptr<int>), "SmartPointer: as small as std::unique_ptr");
+static_assert(sizeof(SmartPointer<int, BorrowedOwnership, AssertChecking>) == sizeof(int*), "SmartPointer: BorrowedOwnership is a raw pointer");
+static_assert(sizeof(SmartPointer<int, CountedOwnership<SingleThreaded>>) == 2 * sizeof(void*), "SmartPointer: a pointer to the count");
+static_assert(sizeof(SmartPointer<int, CountedOwnership<MultiThreaded>>) == sizeof(std::shared_ptr<int>), "SmartPointer: as small as std::shared_ptr");
+static_assert(sizeof(SmartPointer<int, UniqueOwnership, NoChecking, ArenaStorage>) == sizeof(std::unique_ptr<int, ArenaDeleter<int>>),
+              "SmartPointer: as small as std::unique_ptr with an ArenaDeleter");
+
+//The operations that each ownership allows
+static_assert(!std::is_copy_constructible<SmartPointer<int, ScopedOwnership>>::value && !std::is_move_constructible<SmartPointer<int, ScopedOwnership>>::value,
+              "SmartPointer: ScopedOwnership can't be copied nor moved");
+static_assert(!std::is_copy_constructible<SmartPointer<int>>::value && !std::is_copy_assignable<SmartPointer<int>>::value,
+              "SmartPointer: UniqueOwnership can't be copied, which fixes the double delete of main.cpp");
+static_assert(std::is_nothrow_move_constructible<SmartPointer<int>>::value && std::is_nothrow_move_assignable<SmartPointer<int>>::value,
+              "SmartPointer: UniqueOwnership moves without throwing");
+static_assert(std::is_copy_constructible<SmartPointer<int, CountedOwnership<SingleThreaded>>>::value, "SmartPointer: CountedOwnership can be copied");
+static_assert(std::is_copy_assignable<SmartPointer<int, BorrowedOwnership>>::value, "SmartPointer: BorrowedOwnership can be copied");
+
+//The storages that convert
+struct ConversionBase { virtual ~ConversionBase() = default; };
+struct ConversionDerived : ConversionBase { long extra; };
+static_assert(std::is_constructible<SmartPointer<ConversionBase>, SmartPointer<ConversionDerived>&&>::value,
+              "SmartPointer: DefaultStorage converts to a pointer to a base");
+static_assert(!std::is_constructible<SmartPointer<ConversionBase, UniqueOwnership, NoChecking, ArenaStorage>,
+                                     SmartPointer<ConversionDerived, UniqueOwnership, NoChecking, ArenaStorage>&&>::value,
+              "SmartPointer: ArenaStorage would give back the block of a Derived as a Base");
+}
+}
+
+#endif // SMARTPOINTER_H
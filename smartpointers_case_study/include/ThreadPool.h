@@ -0,0 +1,55 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*A work-stealing thread pool. Each worker has its own queue: it takes its tasks from the back,
+and when it runs out, it steals from the front of the queues of the others. The tasks submitted
+by a worker go to its own queue, so a task that splits its work keeps it on the same core unless
+another worker is idle. Each queue has its own lock, that is only contended by stealing.*/
+
+namespace util
+{
+class ThreadPool
+{
+    public:
+        explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+        //Runs the tasks that are still queued, then joins the workers
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> task);
+        unsigned size() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        void run(unsigned index);
+        bool pop(unsigned index, std::function<void()>& task);
+        bool steal(unsigned thief, std::function<void()>& task);
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+        //Tasks queued and not taken yet
+        std::atomic<std::ptrdiff_t> pending_{0};
+        std::atomic<unsigned> sleepers_{0};
+        std::atomic<unsigned> nextWorker_{0};
+        std::mutex sleepMutex_;
+        std::condition_variable wakeUp_;
+        bool stopping_ = false;
+};
+}
+
+#endif // THREADPOOL_H
@@ -0,0 +1,173 @@
+#ifndef TRANSFERUNIQUE_H
+#define TRANSFERUNIQUE_H
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <vector>
+#include "UniquePointerSet.h"
+
+/*main.cpp shows that before C++17 the unique_ptrs of a std::set can't be moved to another set
+with std::move or insert, and concludes that we have to either clone them through cloneBase() or
+give up the set. transferUnique moves all the elements of source to destination without cloning,
+for every combination of std::set, std::vector and FlatUniquePointerSet:
+    set -> set : destination.merge(source) in C++17. Before, each element is moved out of its node
+    (see moveOut below) and inserted with a hint, walking both sorted sets once.
+    flat set -> flat set : one linear merge of the two sorted vectors, no allocation per element.
+    vector -> set or flat set : the vector is sorted once, then merged like a set.
+    anything -> vector : the elements are appended, a vector doesn't look for duplicates.
+Like std::set::merge, the elements that are already in destination stay behind in source, and the
+report says how many were moved and how many stayed.*/
+
+namespace util
+{
+struct TransferReport
+{
+    std::size_t transferred;
+    std::size_t duplicates;
+};
+
+namespace detail
+{
+/*The elements of a std::set are only given as const, because modifying them could break the order
+of the set. Moving the unique_ptr out and erasing its node right after, with no comparison in
+between, never lets the set see the empty unique_ptr, so the const_cast is safe here.*/
+template<typename T, typename Compare>
+std::unique_ptr<T> moveOut(std::set<std::unique_ptr<T>, Compare>& source, typename std::set<std::unique_ptr<T>, Compare>::iterator& it)
+{
+    std::unique_ptr<T> pointer = std::move(const_cast<std::unique_ptr<T>&>(*it));
+    it = source.erase(it);
+    return pointer;
+}
+}
+
+template<typename T, typename Compare>
+TransferReport transferUnique(std::set<std::unique_ptr<T>, Compare>& destination, std::set<std::unique_ptr<T>, Compare>& source)
+{
+    std::size_t const before = destination.size();
+#if __cplusplus >= 201703L
+    destination.merge(source);
+#else
+    Compare const compare = destination.key_comp();
+    auto hint = destination.begin();
+    for (auto it = source.begin(); it != source.end();)
+    {
+        while (hint != destination.end() && compare(*hint, *it))
+        {
+            ++hint;
+        }
+        if (hint != destination.end() && !compare(*it, *hint))
+        {
+            ++it;
+            continue;
+        }
+        hint = std::next(destination.insert(hint, detail::moveOut(source, it)));
+    }
+#endif
+    return {destination.size() - before, source.size()};
+}
+
+template<typename T, typename Compare>
+TransferReport transferUnique(std::set<std::unique_ptr<T>, Compare>& destination, std::vector<std::unique_ptr<T>>& source)
+{
+    Compare const compare = destination.key_comp();
+    if (!std::is_sorted(source.begin(), source.end(), compare))
+    {
+        std::stable_sort(source.begin(), source.end(), compare);
+    }
+    std::vector<std::unique_ptr<T>> duplicates;
+    std::size_t transferred = 0;
+    auto hint = destination.begin();
+    for (auto& pointer : source)
+    {
+        while (hint != destination.end() && compare(*hint, pointer))
+        {
+            ++hint;
+        }
+        //Equivalent to the next element of destination, or to the previous one of source
+        bool const inDestination = hint != destination.end() && !compare(pointer, *hint);
+        bool const repeated = hint != destination.begin() && !compare(*std::prev(hint), pointer);
+        if (inDestination || repeated)
+        {
+            duplicates.push_back(std::move(pointer));
+            continue;
+        }
+        hint = std::next(destination.insert(hint, std::move(pointer)));
+        ++transferred;
+    }
+    source = std::move(duplicates);
+    return {transferred, source.size()};
+}
+
+template<typename T, typename KeyOf>
+TransferReport transferUnique(FlatUniquePointerSet<T, KeyOf>& destination, FlatUniquePointerSet<T, KeyOf>& source)
+{
+    std::size_t const transferred = destination.merge(source);
+    return {transferred, source.size()};
+}
+
+template<typename T, typename KeyOf>
+TransferReport transferUnique(FlatUniquePointerSet<T, KeyOf>& destination, std::vector<std::unique_ptr<T>>& source)
+{
+    std::size_t const transferred = destination.merge(source);
+    return {transferred, source.size()};
+}
+
+//The duplicates are few in general, so they are the ones that are put back
+template<typename T, typename KeyOf, typename Compare>
+TransferReport transferUnique(FlatUniquePointerSet<T, KeyOf>& destination, std::set<std::unique_ptr<T>, Compare>& source)
+{
+    std::vector<std::unique_ptr<T>> pointers;
+    pointers.reserve(source.size());
+    for (auto it = source.begin(); it != source.end();)
+    {
+        pointers.push_back(detail::moveOut(source, it));
+    }
+    std::size_t const transferred = destination.merge(pointers);
+    for (auto& duplicate : pointers)
+    {
+        source.insert(source.end(), std::move(duplicate));
+    }
+    return {transferred, source.size()};
+}
+
+template<typename T, typename Compare, typename KeyOf>
+TransferReport transferUnique(std::set<std::unique_ptr<T>, Compare>& destination, FlatUniquePointerSet<T, KeyOf>& source)
+{
+    std::vector<std::unique_ptr<T>> pointers = source.release();
+    TransferReport const report = transferUnique(destination, pointers);
+    source.insert(std::move(pointers));
+    return report;
+}
+
+template<typename T, typename Compare>
+TransferReport transferUnique(std::vector<std::unique_ptr<T>>& destination, std::set<std::unique_ptr<T>, Compare>& source)
+{
+    std::size_t const transferred = source.size();
+    destination.reserve(destination.size() + transferred);
+    for (auto it = source.begin(); it != source.end();)
+    {
+        destination.push_back(detail::moveOut(source, it));
+    }
+    return {transferred, 0};
+}
+
+template<typename T>
+TransferReport transferUnique(std::vector<std::unique_ptr<T>>& destination, std::vector<std::unique_ptr<T>>& source)
+{
+    std::size_t const transferred = source.size();
+    std::move(source.begin(), source.end(), std::back_inserter(destination));
+    source.clear();
+    return {transferred, 0};
+}
+
+template<typename T, typename KeyOf>
+TransferReport transferUnique(std::vector<std::unique_ptr<T>>& destination, FlatUniquePointerSet<T, KeyOf>& source)
+{
+    std::vector<std::unique_ptr<T>> pointers = source.release();
+    return transferUnique(destination, pointers);
+}
+}
+
+#endif // TRANSFERUNIQUE_H
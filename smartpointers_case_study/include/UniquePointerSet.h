@@ -0,0 +1,301 @@
+#ifndef UNIQUEPOINTERSET_H
+#define UNIQUEPOINTERSET_H
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*The set of unique_ptrs without logical duplicates of main.cpp: ComparePointee compares the
+pointed-to objects instead of the addresses. It is transparent, so the set can also be searched
+with a key that Base compares with, without building a unique_ptr.*/
+
+namespace util
+{
+struct ComparePointee
+{
+    using is_transparent = void;
+
+    template<typename T, typename U>
+    bool operator()(std::unique_ptr<T> const& up1, std::unique_ptr<U> const& up2) const
+    {
+        return *up1 < *up2;
+    }
+
+    template<typename T, typename Key>
+    bool operator()(std::unique_ptr<T> const& up, Key const& key) const
+    {
+        return *up < key;
+    }
+
+    template<typename Key, typename T>
+    bool operator()(Key const& key, std::unique_ptr<T> const& up) const
+    {
+        return key < *up;
+    }
+};
+
+template<typename T>
+using UniquePointerSet = std::set<std::unique_ptr<T>, ComparePointee>;
+
+/*std::set allocates a node per element, and every comparison goes from the tree node to the
+unique_ptr to the pointee. FlatUniquePointerSet keeps the unique_ptrs sorted in a std::vector
+instead: lookups are a binary search over contiguous memory and iteration is a linear scan.
+Inserting one element is O(n), so batches should go through insert(std::vector), which sorts and
+removes the duplicates once.*/
+
+/*If KeyOf is given, the set stores KeyOf()(object) next to each pointer and compares the keys
+only: comparisons then never touch the pointees. The key must not change while the object is in
+the set, just like the part of the object that ComparePointee looks at.*/
+
+namespace detail
+{
+template<typename T, typename KeyOf>
+struct FlatSlot
+{
+    using Key = std::decay_t<decltype(KeyOf()(std::declval<T const&>()))>;
+
+    explicit FlatSlot(std::unique_ptr<T> p) : key(KeyOf()(*p)), pointer(std::move(p)) {}
+
+    Key const& compared() const { return key; }
+
+    Key key;
+    std::unique_ptr<T> pointer;
+};
+
+template<typename T>
+struct FlatSlot<T, void>
+{
+    explicit FlatSlot(std::unique_ptr<T> p) : pointer(std::move(p)) {}
+
+    T const& compared() const { return *pointer; }
+
+    std::unique_ptr<T> pointer;
+};
+
+template<typename Slot>
+struct CompareSlot
+{
+    bool operator()(Slot const& s1, Slot const& s2) const { return s1.compared() < s2.compared(); }
+    template<typename Key>
+    bool operator()(Slot const& s, Key const& key) const { return s.compared() < key; }
+    template<typename Key>
+    bool operator()(Key const& key, Slot const& s) const { return key < s.compared(); }
+};
+}
+
+template<typename T, typename KeyOf = void>
+class FlatUniquePointerSet
+{
+    private:
+        using Slot = detail::FlatSlot<T, KeyOf>;
+        using Slots = std::vector<Slot>;
+        using Compare = detail::CompareSlot<Slot>;
+
+    public:
+        //Iterates over the unique_ptrs, as const like in a std::set
+        class const_iterator
+        {
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = std::unique_ptr<T>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = std::unique_ptr<T> const*;
+                using reference = std::unique_ptr<T> const&;
+
+                const_iterator() = default;
+                explicit const_iterator(typename Slots::const_iterator it) : it_(it) {}
+
+                reference operator*() const { return it_->pointer; }
+                pointer operator->() const { return &it_->pointer; }
+                reference operator[](difference_type n) const { return it_[n].pointer; }
+                const_iterator& operator++() { ++it_; return *this; }
+                const_iterator operator++(int) { return const_iterator(it_++); }
+                const_iterator& operator--() { --it_; return *this; }
+                const_iterator operator--(int) { return const_iterator(it_--); }
+                const_iterator& operator+=(difference_type n) { it_ += n; return *this; }
+                const_iterator& operator-=(difference_type n) { it_ -= n; return *this; }
+                const_iterator operator+(difference_type n) const { return const_iterator(it_ + n); }
+                const_iterator operator-(difference_type n) const { return const_iterator(it_ - n); }
+                difference_type operator-(const_iterator other) const { return it_ - other.it_; }
+                bool operator==(const_iterator other) const { return it_ == other.it_; }
+                bool operator!=(const_iterator other) const { return it_ != other.it_; }
+                bool operator<(const_iterator other) const { return it_ < other.it_; }
+                bool operator>(const_iterator other) const { return it_ > other.it_; }
+                bool operator<=(const_iterator other) const { return it_ <= other.it_; }
+                bool operator>=(const_iterator other) const { return it_ >= other.it_; }
+
+            private:
+                friend class FlatUniquePointerSet;
+                typename Slots::const_iterator it_;
+        };
+        using iterator = const_iterator;
+
+        const_iterator begin() const noexcept { return const_iterator(slots_.begin()); }
+        const_iterator end() const noexcept { return const_iterator(slots_.end()); }
+        std::size_t size() const noexcept { return slots_.size(); }
+        bool empty() const noexcept { return slots_.empty(); }
+        void reserve(std::size_t capacity) { slots_.reserve(capacity); }
+        void clear() noexcept { slots_.clear(); }
+
+        /*Unlike std::set::insert, a duplicate is left in the argument instead of being destroyed,
+        so that the caller can decide what to do with it.*/
+        std::pair<const_iterator, bool> insert(std::unique_ptr<T>&& pointer)
+        {
+            Slot slot(std::move(pointer));
+            auto const position = std::lower_bound(slots_.begin(), slots_.end(), slot, Compare());
+            if (position != slots_.end() && !(slot.compared() < position->compared()))
+            {
+                pointer = std::move(slot.pointer);
+                return {const_iterator(position), false};
+            }
+            return {const_iterator(slots_.insert(position, std::move(slot))), true};
+        }
+
+        /*Bulk insert: sorts the new elements once, drops their duplicates (the first one is kept,
+        and the elements already in the set win) and merges them in. Returns how many were added.*/
+        std::size_t insert(std::vector<std::unique_ptr<T>> pointers)
+        {
+            return merge(pointers);
+        }
+
+        /*Like std::set::merge in C++17: takes over the elements of source that are not already
+        here, and leaves the duplicates in source. Both sets are sorted, so this is a single linear
+        pass, and the pointees are neither copied nor moved. Returns how many were taken.*/
+        std::size_t merge(FlatUniquePointerSet& source)
+        {
+            if (&source == this)
+            {
+                return 0;
+            }
+            Slots duplicates;
+            std::size_t const added = mergeSorted(std::move(source.slots_), &duplicates);
+            source.slots_ = std::move(duplicates);
+            return added;
+        }
+
+        //The same from a std::vector, which is sorted first. Its duplicates stay in source
+        std::size_t merge(std::vector<std::unique_ptr<T>>& source)
+        {
+            Slots incoming;
+            incoming.reserve(source.size());
+            for (auto& pointer : source)
+            {
+                incoming.emplace_back(std::move(pointer));
+            }
+            if (!std::is_sorted(incoming.begin(), incoming.end(), Compare()))
+            {
+                std::stable_sort(incoming.begin(), incoming.end(), Compare());
+            }
+            Slots duplicates;
+            std::size_t const added = mergeSorted(std::move(incoming), &duplicates);
+            source.clear();
+            for (auto& duplicate : duplicates)
+            {
+                source.push_back(std::move(duplicate.pointer));
+            }
+            return added;
+        }
+
+        template<typename Key>
+        const_iterator find(Key const& key) const
+        {
+            auto const position = std::lower_bound(slots_.begin(), slots_.end(), key, Compare());
+            if (position != slots_.end() && !(key < position->compared()))
+            {
+                return const_iterator(position);
+            }
+            return end();
+        }
+
+        template<typename Key>
+        bool contains(Key const& key) const { return find(key) != end(); }
+
+        template<typename Key>
+        std::size_t count(Key const& key) const { return contains(key) ? 1 : 0; }
+
+        template<typename Key>
+        const_iterator lower_bound(Key const& key) const
+        {
+            return const_iterator(std::lower_bound(slots_.begin(), slots_.end(), key, Compare()));
+        }
+
+        const_iterator erase(const_iterator position)
+        {
+            return const_iterator(slots_.erase(position.it_));
+        }
+
+        template<typename Key>
+        std::size_t erase(Key const& key)
+        {
+            auto const position = find(key);
+            if (position == end())
+            {
+                return 0;
+            }
+            erase(position);
+            return 1;
+        }
+
+        //Takes all the elements out of the set, in order, without copying the pointees
+        std::vector<std::unique_ptr<T>> release()
+        {
+            std::vector<std::unique_ptr<T>> pointers;
+            pointers.reserve(slots_.size());
+            for (auto& slot : slots_)
+            {
+                pointers.push_back(std::move(slot.pointer));
+            }
+            slots_.clear();
+            return pointers;
+        }
+
+        //Takes an element out of the set, without copying the pointee
+        std::unique_ptr<T> extract(const_iterator position)
+        {
+            auto const slot = slots_.begin() + (position.it_ - slots_.cbegin());
+            std::unique_ptr<T> pointer = std::move(slot->pointer);
+            slots_.erase(slot);
+            return pointer;
+        }
+
+    private:
+        /*incoming is sorted. Its elements that are equivalent to one already in the set, or to one
+        before them in incoming, go to duplicates in their original order.*/
+        std::size_t mergeSorted(Slots incoming, Slots* duplicates)
+        {
+            Slots merged;
+            merged.reserve(slots_.size() + incoming.size());
+            std::size_t added = 0;
+            std::size_t lastAdded = 0;
+            auto existing = slots_.begin();
+            for (auto& slot : incoming)
+            {
+                while (existing != slots_.end() && existing->compared() < slot.compared())
+                {
+                    merged.push_back(std::move(*existing++));
+                }
+                bool const inSet = existing != slots_.end() && !(slot.compared() < existing->compared());
+                bool const repeated = added > 0 && !(merged[lastAdded].compared() < slot.compared());
+                if (inSet || repeated)
+                {
+                    duplicates->push_back(std::move(slot));
+                    continue;
+                }
+                lastAdded = merged.size();
+                merged.push_back(std::move(slot));
+                ++added;
+            }
+            std::move(existing, slots_.end(), std::back_inserter(merged));
+            slots_ = std::move(merged);
+            return added;
+        }
+
+        Slots slots_;
+};
+}
+
+#endif // UNIQUEPOINTERSET_H
@@ -0,0 +1,279 @@
+#ifndef WEAKCACHE_H
+#define WEAKCACHE_H
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Instrumentation.h"
+
+/*The cache described in the std::weak_ptr section of main.cpp: it maps ids to std::weak_ptrs, so
+it never keeps an object alive by itself, and find() returns the object through lock() as long as
+someone else still holds it. Expired slots are removed when a lookup runs into them, and every
+shard is swept regularly when new entries come in.*/
+
+/*Objects that are looked up often but that nobody holds between two lookups would be destroyed and
+rebuilt all the time. To avoid that, the cache can also keep a strong reference on a fixed number
+of objects (retainedCapacity). They are chosen like in an LRU, but with the CLOCK approximation:
+a lookup only sets a flag on the entry, and the flags are read when a retained slot has to be
+replaced. This way readers never have to reorder a list, and only take a shared lock.*/
+
+/*The entries are split in shards, each with its own lock, so that readers of different ids don't
+contend with each other.*/
+
+namespace util
+{
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class WeakCache
+{
+    public:
+        explicit WeakCache(std::size_t retainedCapacity = 0, std::size_t shardCount = 64)
+            : shardCount_(roundUpToPowerOfTwo(shardCount)),
+              shards_(new Shard[shardCount_])
+        {
+            std::size_t const retainedPerShard = (retainedCapacity + shardCount_ - 1) / shardCount_;
+            for (std::size_t i = 0; i < shardCount_; ++i)
+            {
+                shards_[i].retained.reserve(retainedPerShard);
+                shards_[i].retainedCapacity = retainedPerShard;
+            }
+        }
+
+        //Returns the object if it is still alive, or nullptr
+        std::shared_ptr<Value> find(const Key& key) const
+        {
+            Shard& shard = shardFor(key);
+            {
+                std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+                auto const it = shard.entries.find(key);
+                if (it == shard.entries.end())
+                {
+                    return nullptr;
+                }
+                if (std::shared_ptr<Value> value = instrument::lock(it->second.weak))
+                {
+                    it->second.touch();
+                    return value;
+                }
+            }
+            //The object is no longer here: its slot goes away
+            std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+            auto const it = shard.entries.find(key);
+            if (it != shard.entries.end() && it->second.weak.expired())
+            {
+                shard.entries.erase(it);
+            }
+            return nullptr;
+        }
+
+        /*Returns the cached object, or builds it with factory() and caches it. factory() runs
+        without any lock, so a slow one doesn't block the other readers of the shard, and it may
+        use the cache itself. Two threads that miss the same key at the same time may then both
+        build it: the first one to insert wins, and the object of the other one is dropped.*/
+        template<typename Factory>
+        std::shared_ptr<Value> findOrCreate(const Key& key, Factory&& factory)
+        {
+            if (std::shared_ptr<Value> value = find(key))
+            {
+                return value;
+            }
+            std::shared_ptr<Value> value = factory();
+            Shard& shard = shardFor(key);
+            std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+            //Another thread may have created it in the meantime
+            auto const it = shard.entries.find(key);
+            if (it != shard.entries.end())
+            {
+                if (std::shared_ptr<Value> existing = it->second.weak.lock())
+                {
+                    return existing;
+                }
+            }
+            insertLocked(shard, key, value);
+            return value;
+        }
+
+        void insert(const Key& key, std::shared_ptr<Value> value)
+        {
+            Shard& shard = shardFor(key);
+            std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+            insertLocked(shard, key, std::move(value));
+        }
+
+        void erase(const Key& key)
+        {
+            Shard& shard = shardFor(key);
+            std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+            auto const it = shard.entries.find(key);
+            if (it == shard.entries.end())
+            {
+                return;
+            }
+            if (it->second.ring != NotRetained)
+            {
+                shard.retained[it->second.ring].second.reset();
+            }
+            shard.entries.erase(it);
+        }
+
+        //Removes all the expired slots and returns how many there were
+        std::size_t purgeExpired()
+        {
+            std::size_t purged = 0;
+            for (std::size_t i = 0; i < shardCount_; ++i)
+            {
+                std::unique_lock<std::shared_timed_mutex> lock(shards_[i].mutex);
+                purged += sweep(shards_[i]);
+            }
+            return purged;
+        }
+
+        //Number of slots, including the ones whose object has expired but is not purged yet
+        std::size_t size() const
+        {
+            std::size_t size = 0;
+            for (std::size_t i = 0; i < shardCount_; ++i)
+            {
+                std::shared_lock<std::shared_timed_mutex> lock(shards_[i].mutex);
+                size += shards_[i].entries.size();
+            }
+            return size;
+        }
+
+    private:
+        static constexpr std::size_t NotRetained = static_cast<std::size_t>(-1);
+
+        struct Entry
+        {
+            explicit Entry(std::weak_ptr<Value> value) : weak(std::move(value)) {}
+
+            //Only writes when the flag changes, so that hot entries don't bounce between cores
+            void touch() const noexcept
+            {
+                if (!referenced.load(std::memory_order_relaxed))
+                {
+                    referenced.store(true, std::memory_order_relaxed);
+                }
+            }
+
+            std::weak_ptr<Value> weak;
+            mutable std::atomic<bool> referenced{false};
+            //The slot of the entry in Shard::retained, if it has one
+            std::size_t ring = NotRetained;
+        };
+
+        struct Shard
+        {
+            mutable std::shared_timed_mutex mutex;
+            std::unordered_map<Key, Entry, Hash> entries;
+            //The strong retention tier, used as a ring by the CLOCK hand
+            std::vector<std::pair<Key, std::shared_ptr<Value>>> retained;
+            std::size_t retainedCapacity = 0;
+            std::size_t hand = 0;
+            std::size_t insertsSinceSweep = 0;
+        };
+
+        static std::size_t roundUpToPowerOfTwo(std::size_t value)
+        {
+            std::size_t power = 1;
+            while (power < value)
+            {
+                power *= 2;
+            }
+            return power;
+        }
+
+        Shard& shardFor(const Key& key) const
+        {
+            return shards_[Hash()(key) & (shardCount_ - 1)];
+        }
+
+        void insertLocked(Shard& shard, const Key& key, std::shared_ptr<Value> value)
+        {
+            auto it = shard.entries.find(key);
+            if (it != shard.entries.end())
+            {
+                it->second.weak = value;
+            }
+            else
+            {
+                it = shard.entries.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(value)).first;
+            }
+            retain(shard, it->second, key, std::move(value));
+            //Sweeping after about half as many inserts as the shard has entries keeps it amortized O(1)
+            if (++shard.insertsSinceSweep > shard.entries.size() / 2 + 16)
+            {
+                sweep(shard);
+            }
+        }
+
+        void retain(Shard& shard, Entry& entry, const Key& key, std::shared_ptr<Value> value)
+        {
+            if (shard.retainedCapacity == 0)
+            {
+                return;
+            }
+            //A key that is inserted again keeps its slot, with the new object
+            if (entry.ring != NotRetained)
+            {
+                shard.retained[entry.ring].second = std::move(value);
+                return;
+            }
+            if (shard.retained.size() < shard.retainedCapacity)
+            {
+                entry.ring = shard.retained.size();
+                shard.retained.emplace_back(key, std::move(value));
+                return;
+            }
+            //Second chance: referenced entries get their flag cleared and are skipped once
+            for (;;)
+            {
+                std::size_t const position = shard.hand;
+                auto& slot = shard.retained[position];
+                shard.hand = (shard.hand + 1) % shard.retained.size();
+                auto const it = shard.entries.find(slot.first);
+                bool const owner = it != shard.entries.end() && it->second.ring == position;
+                if (owner && slot.second && it->second.referenced.exchange(false, std::memory_order_relaxed))
+                {
+                    continue;
+                }
+                if (owner)
+                {
+                    it->second.ring = NotRetained;
+                }
+                slot = std::make_pair(key, std::move(value));
+                entry.ring = position;
+                return;
+            }
+        }
+
+        static std::size_t sweep(Shard& shard)
+        {
+            shard.insertsSinceSweep = 0;
+            std::size_t purged = 0;
+            for (auto it = shard.entries.begin(); it != shard.entries.end();)
+            {
+                if (it->second.weak.expired())
+                {
+                    it = shard.entries.erase(it);
+                    ++purged;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            return purged;
+        }
+
+        std::size_t shardCount_;
+        std::unique_ptr<Shard[]> shards_;
+};
+}
+
+#endif // WEAKCACHE_H
@@ -13,6 +13,7 @@ using std::list;
 
 int main()
 {
+    //The idioms below are measured side by side in bench/OwnershipPatternsBench.cpp (see CMakeLists.txt)
 
     //Objects allocated on Stack vs Heap
 
@@ -43,6 +44,7 @@ int main()
     //SmartPointer<int> sp2 = sp1; // now both sp1 and sp2 point to
     // the same object
     } // sp1 and sp2 are both destroyed, the pointer is deleted twice!
+    //util::SmartPointer in SmartPointer.h is this template with the choice made by policies: scoped, unique, counted or borrowed
 
     //Smart Pointers Types
     /*
@@ -112,6 +114,8 @@ int main()
     domain . Using shared pointers then reflects it in an expressive way. Typically, the nodes of a
     graphs are well represented as shared pointers, because several nodes can hold a reference to
     one other node.*/
+    //When the control block and the atomic count cost too much, see the intrusive pointer in IntrusivePtr.h
+    //For read-mostly data shared between threads, see EpochPtr.h: readers don't touch any count at all
 
     //std::weak_ptr
 
@@ -138,12 +142,17 @@ int main()
     std::shared_ptr<House> house2 = std::make_shared<House>();;
     house1->neighbour = house2;
     house2->neighbour = house1;*/
+    //(For graphs of millions of nodes, util::SlotMap in SlotMap.h replaces both with 32-bit generational handles)
+    //(When the back edges can't all be found, util::CyclePtr in CyclePtr.h reclaims the cycles with a collector)
+    //(A long chain of houses that own their neighbour with unique_ptrs overflows the stack when destroyed: see util::LinkPtr in LinkPtr.h)
+    //(To save such a graph in a file that is mapped back at startup instead of rebuilt, see util::OffsetPtr in OffsetPtr.h and MappedImage.h)
     /*None of the houses ends up being destroyed at the end of this code, because the shared_ptr s
     points into one another. But if one is a weak_ptr instead, there is no longer a circular
     reference.
     Another use case pointed out by this answer https://stackoverflow.com/questions/12030650/when-is-stdweak-ptr-useful
     on Stack Overflow is that weak_ptr can be used to maintain a cache . The data may or may not have been cleared from the cache, and the
     weak_ptr references this data.*/
+    //Such a cache, shared between threads, is implemented in WeakCache.h
 
     //boost::scoped_ptr
     /*It simply disables the copy and even the move construction. So it is the sole owner of a resource,
@@ -163,12 +172,17 @@ int main()
     // p1 is now empty and p2 uses the resource
 
     //PIMPL IDIOM by using unique_ptr (See Fridge.h and Fridge.cpp)
+    //Fast pimpl: the impl stored inside the object, without heap allocation (See FastPimpl.h)
+    //Pimpl in an arena, released per batch instead of per object (See Arena.h and ArenaPimpl)
+    //An impl and the sub-objects it owns in a single allocation, reached by offsets (See util::makeAggregate in Aggregate.h)
+    //Many Fridges at once, on a work-stealing pool (See Fridge::coolDown(fridges, count, pool) and ThreadPool.h)
 
     //How to Transfer unique_ptr from a set to another set
 
     /*Given a base class and a derived one. If we want a collection of several objects implementing Base, but that could be of any
     derived classes and we want to prevent our collection to have duplicates, we could use std::set
     std::set<std::unique_ptr<Base>>*/
+    //(util::PolymorphicCollection in PolymorphicCollection.h keeps each derived type contiguous, by value, with moves of whole segments)
 
     /*operator== is not used by std::set. Elements a and b are considered equal iff(if and only if) !(a < b) && !(b < a)
     therefore the comparison between elements of the set will call the operator< of std::unique_ptr ,
@@ -203,6 +217,7 @@ int main()
     But this leads to a compilation error!
     Indeed, the insert methods attemps to make a copy of the unique_ptr elements.
     */
+    //ComparePointee, UniquePointerSet and a flat, sorted-vector version are in UniquePointerSet.h
     //C++17's new method on set: merge
     /*
     destination.merge(source);
@@ -211,6 +226,7 @@ int main()
     source is empty.
     */
     //Pre C++17
+    //(util::transferUnique in TransferUnique.h moves them anyway, without clones, and keeps the duplicates in source)
     /*
     We can't use std::move
     The standard algorithm to move elements from a collection to another collection is std::move .
@@ -260,6 +276,7 @@ int main()
 //    {
 //    destination.insert(pointer->cloneBase());
 //    }
+    //(util::PolymorphicValue in PolymorphicValue.h copies like a value, without cloneBase nor heap allocation for small objects)
 
     //Keeping the move and throwing away the set
     /*The set that doesn't let the move happen is the source set. If you only need the destination to
@@ -268,6 +285,7 @@ int main()
 
 
     //Custom deleters
+    //(DeferredReclaimer.h has a deleter that hands the objects to a background thread, to keep big teardowns off a latency-critical one)
     /*Let's take the example of a House class, that carries its building Instructions with it, which are
     polymorphic and can be either a Sketch or a full-fledged Blueprint. One way to deal with the life cycle of the Instructions is to store them as a unique_ptr in
     the House . And say that a copy of the house makes a deep copy of the instructions. We can't bind a unique_ptr to a stack-allocated object, because calling delete on it
@@ -355,6 +373,7 @@ int main()
     amount of debugging.*/
 
     //A Unique Interface to simplify custom deleters and their ugliness
+    //(Implemented in CustomUniquePtr.h, with a tag bit instead of the function pointer deleter)
 
     /*
     Use the same interface for all custom deleters on all types .
@@ -400,8 +419,10 @@ int main()
     we can now use auto , thanks to the return type of MakeConstUnique .
     Note that all this made us go down to one occurrence of the namespace of Computer ,
     instead of three.*/
+    //(Built with SMARTPOINTERS_INSTRUMENTATION, Instrumentation.h counts what these helpers allocate, adopt and delete)
 
     //Specific deleters
+    //(DeleterTraits.h declares the disposal function once per type, with no function pointer to store)
 
     /*Now what if, for some reason, we didn't want to call delete on the class Computer, but a
     particular dedicated function?*/
@@ -466,6 +487,7 @@ int main()
     /*http://cpptruths.blogspot.com/2015/11/covariance-and-contravariance-in-c.html*/
     //Use cases: Simple hierarchy, Multiple inheritance, Deep hierarchy, Diamond inheritance (See manual)
     //https://www.fluentcpp.com/2017/05/12/curiously-recurring-template-pattern/
+    //Cloneable.h implements it: clone() returns a unique_ptr to the static type, and clone(arena) copies a whole tree into an Arena
 
     return 0;
 }
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include "Arena.h"
+
+namespace util
+{
+Arena::Arena(std::size_t chunkSize) : chunkSize_(chunkSize)
+{
+}
+
+Arena::~Arena()
+{
+    for (Chunk const& chunk : chunks_)
+    {
+        ::operator delete(chunk.memory);
+    }
+}
+
+//Even an empty block takes Granularity bytes, so that it has a free list and a distinct address
+std::size_t Arena::roundUp(std::size_t size) noexcept
+{
+    return size == 0 ? Granularity : (size + Granularity - 1) / Granularity * Granularity;
+}
+
+void* Arena::allocate(std::size_t size, std::size_t alignment)
+{
+    size = roundUp(size);
+    if (alignment <= Granularity && size <= MaxRecycledSize)
+    {
+        FreeBlock*& freeList = freeLists_[size / Granularity - 1];
+        if (freeList)
+        {
+            FreeBlock* block = freeList;
+            freeList = block->next;
+            return block;
+        }
+    }
+    return allocateFromChunks(size, alignment);
+}
+
+void Arena::deallocate(void* pointer, std::size_t size, std::size_t alignment) noexcept
+{
+    size = roundUp(size);
+    //Bigger blocks are not recycled, they come back with the next reset()
+    if (alignment <= Granularity && size <= MaxRecycledSize)
+    {
+        FreeBlock*& freeList = freeLists_[size / Granularity - 1];
+        freeList = new (pointer) FreeBlock{freeList};
+    }
+}
+
+void* Arena::allocateFromChunks(std::size_t size, std::size_t alignment)
+{
+    for (;;)
+    {
+        void* aligned = current_;
+        std::size_t space = end_ - current_;
+        if (current_ && std::align(alignment, size, aligned, space))
+        {
+            current_ = static_cast<char*>(aligned) + size;
+            return aligned;
+        }
+        //The current chunk is full: move on to the next one big enough, kept from before a reset() or new
+        while (nextChunk_ < chunks_.size() && chunks_[nextChunk_].size < size + alignment)
+        {
+            ++nextChunk_;
+        }
+        if (nextChunk_ == chunks_.size())
+        {
+            std::size_t const bytes = std::max(chunkSize_, size + alignment);
+            chunks_.push_back({static_cast<char*>(::operator new(bytes)), bytes});
+        }
+        current_ = chunks_[nextChunk_].memory;
+        end_ = current_ + chunks_[nextChunk_].size;
+        ++nextChunk_;
+    }
+}
+
+void Arena::reset() noexcept
+{
+    nextChunk_ = 0;
+    current_ = nullptr;
+    end_ = nullptr;
+    for (FreeBlock*& freeList : freeLists_)
+    {
+        freeList = nullptr;
+    }
+}
+
+Arena& Arena::threadLocal()
+{
+    thread_local Arena arena;
+    return arena;
+}
+}
@@ -0,0 +1,464 @@
+#include <algorithm>
+#include <cassert>
+#include "CyclePtr.h"
+
+namespace util
+{
+CycleCollector::~CycleCollector()
+{
+    stopBackground();
+    collect();
+}
+
+CycleCollector& CycleCollector::global()
+{
+    static CycleCollector collector;
+    return collector;
+}
+
+//The object is still referenced, maybe only by a cycle
+void CycleCollector::buffer(Collectable* object)
+{
+    std::lock_guard<std::mutex> lock(rootsMutex_);
+    if (object->flags_.fetch_or(Collectable::Rooted) & Collectable::Rooted)
+    {
+        return;
+    }
+    object->rootIndex_ = roots_.size();
+    roots_.push_back(object);
+}
+
+void CycleCollector::removeRoot(Collectable* object) noexcept
+{
+    std::size_t const index = object->rootIndex_;
+    roots_[index] = roots_.back();
+    roots_[index]->rootIndex_ = index;
+    roots_.pop_back();
+    object->rootIndex_ = Collectable::NotBuffered;
+    object->flags_.fetch_and(static_cast<std::uint8_t>(~Collectable::Rooted));
+}
+
+//Deleting the object releases its CyclePtr members, and so its children
+void CycleCollector::released(Collectable* object)
+{
+    if (object->flags_.fetch_or(Collectable::Released) & (Collectable::Rooted | Collectable::Traced))
+    {
+        return;
+    }
+    /*The edge to the object was cleared before its count reached zero: a step that starts tracing
+    after the fence can't find it, and one that already traces is waited for.*/
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (tracing_.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::recursive_mutex> lock(sliceMutex_);
+    }
+    delete object;
+}
+
+template<typename F>
+void CycleCollector::forEachChild(Collectable* object, F&& f)
+{
+    struct Tracer : CycleTracer
+    {
+        explicit Tracer(F& f) : f(f) {}
+
+        void visit(CyclePtrBase& edge) override
+        {
+            if (Collectable* const child = edge.object_.load(std::memory_order_acquire))
+            {
+                f(child);
+            }
+        }
+
+        F& f;
+    } tracer(f);
+    object->trace(tracer);
+}
+
+/*The references between garbage objects are cut before the destructors run, instead of being
+released by them. The garbage reached for the first time is pushed on pending.*/
+void CycleCollector::cut(Collectable* object, std::vector<Collectable*>* pending)
+{
+    struct Cut : CycleTracer
+    {
+        explicit Cut(std::vector<Collectable*>* pending) : pending(pending) {}
+
+        void visit(CyclePtrBase& edge) override
+        {
+            Collectable* const child = edge.object_.load(std::memory_order_relaxed);
+            if (!child || (child->mark_ != Mark::Garbage && child->mark_ != Mark::Detached))
+            {
+                return;
+            }
+            edge.object_.store(nullptr, std::memory_order_relaxed);
+            if (pending && child->mark_ == Mark::Garbage)
+            {
+                child->mark_ = Mark::Detached;
+                pending->push_back(child);
+            }
+        }
+
+        std::vector<Collectable*>* pending;
+    } cut(pending);
+    object->trace(cut);
+}
+
+//The collection keeps the object until it ends, unless a mutator is about to delete it
+bool CycleCollector::hold(Collectable* object)
+{
+    std::uint8_t const flags = object->flags_.fetch_or(Collectable::Traced);
+    if ((flags & Collectable::Released) && !(flags & Collectable::Rooted))
+    {
+        object->flags_.fetch_and(static_cast<std::uint8_t>(~Collectable::Traced));
+        return false;
+    }
+    object->mark_ = Mark::Unknown;
+    graph_.push_back(object);
+    return true;
+}
+
+bool CycleCollector::begin()
+{
+    std::lock_guard<std::mutex> lock(rootsMutex_);
+    if (roots_.empty())
+    {
+        return false;
+    }
+    for (Collectable* const root : roots_)
+    {
+        root->flags_.fetch_or(Collectable::Traced);
+        root->flags_.fetch_and(static_cast<std::uint8_t>(~Collectable::Rooted));
+        root->rootIndex_ = Collectable::NotBuffered;
+        root->mark_ = Mark::Unknown;
+        graph_.push_back(root);
+    }
+    roots_.clear();
+    candidates_ = graph_.size();
+    pending_ = graph_;
+    aborted_ = false;
+    phase_ = Phase::Gather;
+    return true;
+}
+
+//Walks the subgraph reachable from the candidates
+void CycleCollector::gather(std::size_t& budget)
+{
+    for (; budget > 0 && !pending_.empty(); --budget)
+    {
+        Collectable* const object = pending_.back();
+        pending_.pop_back();
+        forEachChild(object, [this](Collectable* child)
+        {
+            assert(child->collector_ == this && "CyclePtr: an edge between objects of two collectors");
+            if (child->mark_ == Mark::None && hold(child))
+            {
+                pending_.push_back(child);
+            }
+        });
+    }
+    if (pending_.empty())
+    {
+        cursor_ = 0;
+        phase_ = Phase::Snapshot;
+    }
+}
+
+void CycleCollector::snapshot(std::size_t& budget)
+{
+    for (; budget > 0 && cursor_ < graph_.size(); --budget, ++cursor_)
+    {
+        Collectable* const object = graph_[cursor_];
+        object->snapshot_ = object->counter_.load();
+        object->internal_ = 0;
+    }
+    if (cursor_ == graph_.size())
+    {
+        cursor_ = 0;
+        phase_ = Phase::Count;
+    }
+}
+
+//Counts the references that come from inside the subgraph
+void CycleCollector::count(std::size_t& budget)
+{
+    for (; budget > 0 && cursor_ < graph_.size(); --budget, ++cursor_)
+    {
+        forEachChild(graph_[cursor_], [](Collectable* child)
+        {
+            if (child->mark_ != Mark::None)
+            {
+                ++child->internal_;
+            }
+        });
+    }
+    if (cursor_ == graph_.size())
+    {
+        cursor_ = 0;
+        phase_ = Phase::Scan;
+    }
+}
+
+/*What is referenced from outside the subgraph is alive, and so is everything it reaches. An object
+whose count already reached zero is about to release its children, so it keeps them too.*/
+void CycleCollector::scan(std::size_t& budget)
+{
+    for (; budget > 0 && cursor_ < graph_.size(); --budget, ++cursor_)
+    {
+        Collectable* const object = graph_[cursor_];
+        std::uint64_t const count = object->snapshot_ & Collectable::CountMask;
+        if ((count == 0 || count != object->internal_) && object->mark_ != Mark::Live)
+        {
+            object->mark_ = Mark::Live;
+            pending_.push_back(object);
+        }
+    }
+    for (; budget > 0 && !pending_.empty(); --budget)
+    {
+        Collectable* const object = pending_.back();
+        pending_.pop_back();
+        forEachChild(object, [this](Collectable* child)
+        {
+            if (child->mark_ == Mark::Unknown)
+            {
+                child->mark_ = Mark::Live;
+                pending_.push_back(child);
+            }
+        });
+    }
+    if (cursor_ == graph_.size() && pending_.empty())
+    {
+        cursor_ = 0;
+        phase_ = Phase::Validate;
+    }
+}
+
+/*The counts and the edges were read at different times, while the mutators ran. If no reference
+to the garbage was made, moved or dropped since its snapshot, it was all read as it is now.*/
+void CycleCollector::validate(std::size_t& budget)
+{
+    for (; budget > 0 && cursor_ < graph_.size(); --budget, ++cursor_)
+    {
+        Collectable* const object = graph_[cursor_];
+        if (object->mark_ != Mark::Unknown)
+        {
+            continue;
+        }
+        if (object->counter_.load() != object->snapshot_)
+        {
+            aborted_ = true;
+            cursor_ = 0;
+            phase_ = Phase::Release;
+            return;
+        }
+        object->mark_ = Mark::Garbage;
+    }
+    if (cursor_ == graph_.size())
+    {
+        cursor_ = 0;
+        phase_ = Phase::Detach;
+    }
+}
+
+//Each candidate that is garbage, and wasn't reached from an earlier one, is a new cycle
+void CycleCollector::detach(std::size_t& budget)
+{
+    while (budget > 0)
+    {
+        if (pending_.empty())
+        {
+            while (cursor_ < candidates_ && graph_[cursor_]->mark_ != Mark::Garbage)
+            {
+                ++cursor_;
+            }
+            if (cursor_ == candidates_)
+            {
+                cursor_ = 0;
+                phase_ = Phase::Release;
+                return;
+            }
+            graph_[cursor_]->mark_ = Mark::Detached;
+            pending_.push_back(graph_[cursor_]);
+            std::lock_guard<std::mutex> lock(statisticsMutex_);
+            ++statistics_.cyclesReclaimed;
+        }
+        --budget;
+        Collectable* const object = pending_.back();
+        pending_.pop_back();
+        cut(object, &pending_);
+    }
+}
+
+//Hands the objects that are alive back to the mutators, and queues the garbage
+void CycleCollector::release(std::size_t& budget)
+{
+    for (; budget > 0 && cursor_ < graph_.size(); --budget, ++cursor_)
+    {
+        Collectable* const object = graph_[cursor_];
+        if (!aborted_ && (object->mark_ == Mark::Garbage || object->mark_ == Mark::Detached))
+        {
+            if (object->mark_ == Mark::Garbage)
+            {
+                cut(object, nullptr);
+            }
+            if (object->flags_.load() & Collectable::Rooted)
+            {
+                std::lock_guard<std::mutex> lock(rootsMutex_);
+                removeRoot(object);
+            }
+            garbage_.push_back(object);
+            continue;
+        }
+        //Still a candidate, for a collection that isn't disturbed
+        if (aborted_ && object->mark_ != Mark::Live)
+        {
+            buffer(object);
+        }
+        object->mark_ = Mark::None;
+        std::uint8_t const flags = object->flags_.fetch_and(static_cast<std::uint8_t>(~Collectable::Traced));
+        if ((flags & Collectable::Released) && !(flags & Collectable::Rooted))
+        {
+            released_.push_back(object);
+        }
+    }
+    if (cursor_ == graph_.size())
+    {
+        graph_.clear();
+        cursor_ = 0;
+        phase_ = Phase::Delete;
+    }
+}
+
+//Runs the destructors outside of the slice, so that they don't keep the mutators waiting
+std::size_t CycleCollector::reclaim(std::size_t& budget)
+{
+    std::size_t reclaimed = 0;
+    for (; budget > 0 && !garbage_.empty(); --budget, ++reclaimed)
+    {
+        Collectable* const object = garbage_.back();
+        garbage_.pop_back();
+        delete object;
+    }
+    for (; budget > 0 && !released_.empty(); --budget)
+    {
+        Collectable* const object = released_.back();
+        released_.pop_back();
+        delete object;
+    }
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    statistics_.objectsReclaimed += reclaimed;
+    if (garbage_.empty() && released_.empty())
+    {
+        phase_ = Phase::Idle;
+        ++statistics_.collections;
+    }
+    return reclaimed;
+}
+
+std::size_t CycleCollector::advance(std::size_t budget)
+{
+    std::size_t reclaimed = 0;
+    while (budget > 0 && phase_ != Phase::Idle)
+    {
+        if (phase_ == Phase::Delete)
+        {
+            reclaimed += reclaim(budget);
+            continue;
+        }
+        std::lock_guard<std::recursive_mutex> lock(sliceMutex_);
+        auto const start = std::chrono::steady_clock::now();
+        tracing_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (budget > 0 && phase_ != Phase::Delete)
+        {
+            switch (phase_)
+            {
+                case Phase::Gather: gather(budget); break;
+                case Phase::Snapshot: snapshot(budget); break;
+                case Phase::Count: count(budget); break;
+                case Phase::Scan: scan(budget); break;
+                case Phase::Validate: validate(budget); break;
+                case Phase::Detach: detach(budget); break;
+                case Phase::Release: release(budget); break;
+                case Phase::Idle:
+                case Phase::Delete: break;
+            }
+        }
+        tracing_.store(false, std::memory_order_release);
+        auto const pause = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        std::lock_guard<std::mutex> statisticsLock(statisticsMutex_);
+        statistics_.longestPause = std::max(statistics_.longestPause, pause);
+    }
+    return reclaimed;
+}
+
+std::size_t CycleCollector::step(std::size_t budget)
+{
+    std::lock_guard<std::mutex> lock(stepMutex_);
+    if (phase_ == Phase::Idle && !begin())
+    {
+        return 0;
+    }
+    return advance(budget);
+}
+
+std::size_t CycleCollector::collect()
+{
+    std::lock_guard<std::mutex> lock(stepMutex_);
+    std::size_t const unbounded = static_cast<std::size_t>(-1);
+    //Finishes what the background steps left halfway
+    std::size_t reclaimed = advance(unbounded);
+    //The destructors of the garbage may have buffered new candidates
+    while (begin())
+    {
+        std::size_t const more = advance(unbounded);
+        reclaimed += more;
+        if (more == 0)
+        {
+            break;
+        }
+    }
+    return reclaimed;
+}
+
+void CycleCollector::startBackground(std::chrono::milliseconds interval, std::size_t budget)
+{
+    stopBackground();
+    background_ = std::thread([this, interval, budget]
+    {
+        std::unique_lock<std::mutex> lock(backgroundMutex_);
+        while (!backgroundWakeUp_.wait_for(lock, interval, [this] { return stopping_; }))
+        {
+            lock.unlock();
+            step(budget);
+            lock.lock();
+        }
+    });
+}
+
+void CycleCollector::stopBackground()
+{
+    if (!background_.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex_);
+        stopping_ = true;
+    }
+    backgroundWakeUp_.notify_all();
+    background_.join();
+    stopping_ = false;
+}
+
+CycleCollector::Statistics CycleCollector::statistics() const
+{
+    std::lock_guard<std::mutex> lock(statisticsMutex_);
+    return statistics_;
+}
+
+std::size_t CycleCollector::candidateRoots() const
+{
+    std::lock_guard<std::mutex> lock(rootsMutex_);
+    return roots_.size();
+}
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include "DeferredReclaimer.h"
+
+/*The queue is Dmitry Vyukov's bounded queue: each cell carries a sequence number that tells the
+producers and the consumer whose turn it is, so a push is a compare-and-swap on the enqueue
+position followed by a store in the cell. The consumers are serialized by a mutex, that the
+producers never take.*/
+
+namespace util
+{
+namespace
+{
+//The reclaimer whose deleters run on this thread, if any: their own retire() calls must not wait for it
+thread_local DeferredReclaimer const* reclaiming = nullptr;
+
+std::size_t roundUpToPowerOf2(std::size_t value)
+{
+    std::size_t power = 1;
+    while (power < value)
+    {
+        power *= 2;
+    }
+    return power;
+}
+}
+
+DeferredReclaimer::DeferredReclaimer(std::size_t capacity, Overflow overflow, std::size_t batchSize,
+                                     std::chrono::milliseconds interval)
+    : cells_(new Cell[roundUpToPowerOf2(std::max<std::size_t>(capacity, 2))]),
+      mask_(roundUpToPowerOf2(std::max<std::size_t>(capacity, 2)) - 1),
+      batchSize_(std::max<std::size_t>(batchSize, 1)),
+      overflow_(overflow),
+      interval_(interval)
+{
+    for (std::size_t i = 0; i <= mask_; ++i)
+    {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread_ = std::thread([this] { run(); });
+}
+
+DeferredReclaimer::~DeferredReclaimer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_one();
+    thread_.join();
+    drain();
+}
+
+bool DeferredReclaimer::tryPush(Entry entry, std::size_t& position) noexcept
+{
+    position = enqueuePosition_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = cells_[position & mask_];
+        std::size_t const sequence = cell.sequence.load(std::memory_order_acquire);
+        auto const difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+        if (difference == 0)
+        {
+            if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.entry = entry;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            //The consumer hasn't freed this cell yet: full
+            return false;
+        }
+        else
+        {
+            position = enqueuePosition_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool DeferredReclaimer::tryPop(Entry& entry) noexcept
+{
+    Cell& cell = cells_[dequeuePosition_ & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition_ + 1)
+    {
+        //Empty, or the producer of this cell hasn't finished writing it
+        return false;
+    }
+    entry = cell.entry;
+    cell.sequence.store(dequeuePosition_ + mask_ + 1, std::memory_order_release);
+    ++dequeuePosition_;
+    return true;
+}
+
+void DeferredReclaimer::retire(void* pointer, void (*deleter)(void*))
+{
+    std::size_t position;
+    while (!tryPush({pointer, deleter}, position))
+    {
+        if (overflow_ == Overflow::DeleteInline || reclaiming == this)
+        {
+            deletedInline_.fetch_add(1, std::memory_order_relaxed);
+            deleter(pointer);
+            return;
+        }
+        waits_.fetch_add(1, std::memory_order_relaxed);
+        urgent_.store(true, std::memory_order_relaxed);
+        wakeUp_.notify_one();
+        std::unique_lock<std::mutex> lock(mutex_);
+        reclaimedSome_.wait_for(lock, interval_);
+    }
+    //A full batch is waiting: no need to wait for the end of the interval
+    if ((position + 1) % batchSize_ == 0)
+    {
+        urgent_.store(true, std::memory_order_relaxed);
+        wakeUp_.notify_one();
+    }
+}
+
+std::size_t DeferredReclaimer::reclaimBatch()
+{
+    Entry entries[64];
+    std::size_t total = 0;
+    while (total < batchSize_)
+    {
+        //Popped first, so that the cells are free for the producers while the deleters run
+        std::size_t count = 0;
+        while (count < std::min<std::size_t>(64, batchSize_ - total) && tryPop(entries[count]))
+        {
+            ++count;
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            entries[i].deleter(entries[i].pointer);
+        }
+        total += count;
+        reclaimed_.fetch_add(count, std::memory_order_release);
+        if (count < 64)
+        {
+            break;
+        }
+    }
+    if (total > 0)
+    {
+        batches_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::size_t DeferredReclaimer::drain()
+{
+    if (reclaiming == this)
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> consumer(consumerMutex_);
+    reclaiming = this;
+    std::size_t total = 0;
+    for (std::size_t count; (count = reclaimBatch()) > 0;)
+    {
+        total += count;
+    }
+    reclaiming = nullptr;
+    reclaimedSome_.notify_all();
+    return total;
+}
+
+void DeferredReclaimer::flush()
+{
+    //A deleter that flushes would wait for the batch it runs in, that holds consumerMutex_
+    if (reclaiming == this)
+    {
+        return;
+    }
+    std::uint64_t const target = enqueuePosition_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (reclaimed_.load(std::memory_order_acquire) < target)
+    {
+        urgent_.store(true, std::memory_order_relaxed);
+        wakeUp_.notify_one();
+        reclaimedSome_.wait_for(lock, interval_);
+    }
+}
+
+void DeferredReclaimer::run()
+{
+    reclaiming = this;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        wakeUp_.wait_for(lock, interval_, [this] { return stopping_ || urgent_.load(std::memory_order_relaxed); });
+        urgent_.store(false, std::memory_order_relaxed);
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> consumer(consumerMutex_);
+            while (reclaimBatch() > 0)
+            {
+                reclaimedSome_.notify_all();
+            }
+        }
+        lock.lock();
+        reclaimedSome_.notify_all();
+    }
+}
+
+DeferredReclaimer::Statistics DeferredReclaimer::statistics() const noexcept
+{
+    Statistics statistics;
+    statistics.deferred = enqueuePosition_.load(std::memory_order_relaxed);
+    statistics.deletedInline = deletedInline_.load(std::memory_order_relaxed);
+    statistics.waits = waits_.load(std::memory_order_relaxed);
+    statistics.reclaimed = reclaimed_.load(std::memory_order_relaxed);
+    statistics.batches = batches_.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+DeferredReclaimer& DeferredReclaimer::global()
+{
+    static DeferredReclaimer reclaimer;
+    return reclaimer;
+}
+}
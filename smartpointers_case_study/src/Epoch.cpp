@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "EpochPtr.h"
+
+/*Why a retired object can be deleted once no reader is pinned on an epoch older than its tag:
+retire() tags the object with the epoch that it increments, after the pointer has been swapped. A
+reader pinned on an epoch at least as new has read the epoch after the increment, so it reads the
+pointer after the swap and can't see the retired version. For a reader that pinned an older epoch,
+the fences make sure that either reclaim() sees its slot, or the reader sees the new pointer.*/
+
+namespace util
+{
+namespace
+{
+struct Retired
+{
+    void* pointer;
+    void (*deleter)(void*);
+    std::uint64_t epoch;
+};
+
+//Writers are rare: they share a plain lock
+std::mutex retiredMutex;
+std::vector<Retired> retired;
+
+//Below it, the retired objects wait for the next EpochPtr destruction, thread exit or explicit reclaim()
+constexpr std::size_t ReclaimThreshold = 64;
+
+//Deletes what is left at exit, once the other threads are gone
+struct Drain
+{
+    ~Drain()
+    {
+        Epoch::reclaim();
+    }
+} drain;
+}
+
+std::atomic<std::uint64_t> Epoch::global_{0};
+std::atomic<Epoch::Record*> Epoch::records_{nullptr};
+
+Epoch::Record& Epoch::local() noexcept
+{
+    struct Owner
+    {
+        Owner()
+        {
+            for (Record* candidate = records_.load(std::memory_order_acquire); candidate; candidate = candidate->next)
+            {
+                if (!candidate->used.load(std::memory_order_relaxed) && !candidate->used.exchange(true, std::memory_order_acquire))
+                {
+                    record = candidate;
+                    return;
+                }
+            }
+            //new doesn't align on more than alignof(std::max_align_t) before C++17
+            std::size_t space = sizeof(Record) + alignof(Record);
+            void* memory = ::operator new(space);
+            record = new (std::align(alignof(Record), sizeof(Record), memory, space)) Record;
+            record->next = records_.load(std::memory_order_relaxed);
+            while (!records_.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        //The thread can't be pinned any more: what it retired may be deleted now
+        ~Owner()
+        {
+            record->pinned.store(Idle, std::memory_order_release);
+            record->used.store(false, std::memory_order_release);
+            reclaim();
+        }
+
+        Record* record;
+    };
+    thread_local Owner owner;
+    return *owner.record;
+}
+
+void Epoch::retire(void* pointer, void (*deleter)(void*))
+{
+    //A writer that never read has no record yet: it gets one, to reclaim when it exits
+    local();
+    std::uint64_t const epoch = global_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired.push_back({pointer, deleter, epoch});
+        full = retired.size() >= ReclaimThreshold;
+    }
+    if (full)
+    {
+        reclaim();
+    }
+}
+
+std::size_t Epoch::reclaim()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint64_t oldest = Idle;
+    for (Record* record = records_.load(std::memory_order_acquire); record; record = record->next)
+    {
+        oldest = std::min(oldest, record->pinned.load(std::memory_order_seq_cst));
+    }
+    std::vector<Retired> expired;
+    std::size_t left;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        auto const safe = std::partition(retired.begin(), retired.end(), [oldest](Retired const& r) { return r.epoch > oldest; });
+        expired.assign(safe, retired.end());
+        retired.erase(safe, retired.end());
+        left = retired.size();
+    }
+    //The deleters run without the lock, they may retire other objects
+    for (Retired const& r : expired)
+    {
+        r.deleter(r.pointer);
+    }
+    return left;
+}
+}
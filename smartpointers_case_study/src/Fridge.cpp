@@ -1,29 +1,147 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include "Arena.h"
 #include "Engine.h"
 #include "Fridge.h"
+#include "ThreadPool.h"
 
 class Fridge::FridgeImpl
 {
     public:
+        FridgeImpl() : engine_(new (&ownEngine_) Engine()) {}
+        explicit FridgeImpl(util::Arena& arena) : engine_(arena.create<Engine>()), arena_(&arena) {}
+        FridgeImpl(const FridgeImpl&) = delete;
+        FridgeImpl& operator=(const FridgeImpl&) = delete;
+
+        ~FridgeImpl()
+        {
+            if (arena_)
+            {
+                arena_->destroy(engine_);
+            }
+            else
+            {
+                engine_->~Engine();
+            }
+        }
+
         void coolDown(){
-            //
+            coolDown(*engine_);
+        }
+        //In a batch, the Engine of the worker thread does the job
+        //The cooling itself is left out of the example: all it needs is an Engine
+        void coolDown(Engine&){
         }
     private:
-        Engine engine_;
+        Engine* engine_;
+        util::Arena* arena_ = nullptr;
+        //Where engine_ is when there is no arena
+        std::aligned_storage_t<sizeof(Engine), alignof(Engine)> ownEngine_;
 };
 
 Fridge::Fridge() = default;
+Fridge::Fridge(util::Arena& arena) : impl_(arena) {}
 Fridge::~Fridge() = default;
 
 void Fridge::coolDown()
 {
     impl_->coolDown();
 }
-/*
-The class now delegates its functionalities and members to FridgeImpl , and Fridge only has to
-forward the calls and manage the life cycle of the impl_ pointer.
-*/
-/*
-What makes it work is that pointers only need a forward declaration to compile . For
-this reason, the header file of the Fridge class doesn't need to see the full definition of
-FridgeImpl , and therefore neither do Fridge's clients.
-*/
+
+namespace
+{
+Engine& workerEngine()
+{
+    thread_local Engine engine;
+    return engine;
+}
+
+/*Shared by the chunks of a batch: the last chunk to finish fulfils the promise, with the first
+exception thrown by any of them. Settling it earlier would let the caller destroy the Fridges while
+other chunks still use them. The chunks that could not be submitted finish all at once.*/
+struct Batch
+{
+    explicit Batch(std::size_t chunks) : remaining(chunks) {}
+
+    void finish(std::exception_ptr error, std::size_t chunks = 1)
+    {
+        if (error)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!firstError)
+            {
+                firstError = error;
+            }
+        }
+        if (remaining.fetch_sub(chunks) == chunks)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (firstError)
+            {
+                done.set_exception(firstError);
+            }
+            else
+            {
+                done.set_value();
+            }
+        }
+    }
+
+    std::atomic<std::size_t> remaining;
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+    std::promise<void> done;
+};
+}
+
+std::future<void> Fridge::coolDown(Fridge* fridges, std::size_t count, util::ThreadPool& pool, std::size_t chunkSize)
+{
+    chunkSize = std::max<std::size_t>(chunkSize, 1);
+    std::size_t const chunks = (count + chunkSize - 1) / chunkSize;
+    if (chunks == 0)
+    {
+        std::promise<void> done;
+        done.set_value();
+        return done.get_future();
+    }
+    auto batch = std::make_shared<Batch>(chunks);
+    std::future<void> future = batch->done.get_future();
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        std::size_t const first = chunk * chunkSize;
+        std::size_t const last = std::min(first + chunkSize, count);
+        auto task = [batch, fridges, first, last]
+        {
+            std::exception_ptr error;
+            try
+            {
+                Engine& engine = workerEngine();
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    fridges[i].impl_->coolDown(engine);
+                }
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            batch->finish(error);
+        };
+        try
+        {
+            pool.submit(std::move(task));
+        }
+        catch (...)
+        {
+            //The chunks already submitted go on, the future waits for them
+            batch->finish(std::current_exception(), chunks - chunk);
+            break;
+        }
+    }
+    return future;
+}
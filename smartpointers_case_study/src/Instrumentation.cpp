@@ -0,0 +1,345 @@
+#include <ostream>
+#include "Instrumentation.h"
+
+#ifdef SMARTPOINTERS_INSTRUMENTATION
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+namespace util
+{
+namespace instrument
+{
+namespace
+{
+constexpr std::size_t EventCount = 6;
+constexpr std::size_t BucketCount = 64;
+
+char const* const eventNames[EventCount] = {"allocations", "control_blocks", "adopted", "deleter_calls", "weak_locks", "weak_lock_failures"};
+static_assert(sizeof(Counts::events) / sizeof(Counts::events[0]) == EventCount, "Counts must have every event");
+
+std::string demangle(char const* mangledName)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    int status = 0;
+    char* const name = abi::__cxa_demangle(mangledName, nullptr, nullptr, &status);
+    if (status == 0 && name)
+    {
+        std::string demangled(name);
+        std::free(name);
+        return demangled;
+    }
+#endif
+    return mangledName;
+}
+
+//Bucket b holds the values in [2^b, 2^(b+1))
+std::size_t bucket(std::uint64_t value) noexcept
+{
+    std::size_t b = 0;
+    while (value > 1 && b + 1 < BucketCount)
+    {
+        value >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+void writeString(std::ostream& out, std::string const& text)
+{
+    out << '"';
+    for (char const c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+}
+
+struct TypeStats
+{
+    explicit TypeStats(std::string name) : name(std::move(name)) {}
+
+    std::string const name;
+    std::atomic<std::uint64_t> events[EventCount] = {};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> sizes[BucketCount] = {};
+    std::atomic<std::uint64_t> lifetimes[BucketCount] = {};
+};
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+using CallSiteKey = std::tuple<char const*, int, TypeStats const*, std::size_t>;
+
+struct Registry
+{
+    std::atomic<unsigned> samplingPeriod{1};
+
+    std::mutex typesMutex;
+    std::vector<std::unique_ptr<TypeStats>> types;
+
+    //Only the sampled events get here
+    std::mutex sampledMutex;
+    std::map<CallSiteKey, std::uint64_t> callSites;
+    std::unordered_map<void const*, Clock::time_point> births;
+
+    std::mutex dumpMutex;
+    std::condition_variable dumpWakeUp;
+    std::thread dumper;
+    bool stopping = false;
+};
+
+Registry& registry()
+{
+    //Never destroyed, so that the objects destroyed at exit can still be counted
+    static Registry* const instance = new Registry;
+    return *instance;
+}
+}
+
+namespace detail
+{
+TypeStats* registerType(char const* mangledName)
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.typesMutex);
+    r.types.push_back(std::make_unique<TypeStats>(demangle(mangledName)));
+    return r.types.back().get();
+}
+
+bool sampleAddress(void const* pointer) noexcept
+{
+    unsigned const period = registry().samplingPeriod.load(std::memory_order_relaxed);
+    if (period <= 1)
+    {
+        return true;
+    }
+    std::uint64_t const hash = (reinterpret_cast<std::uintptr_t>(pointer) >> 4) * 0x9E3779B97F4A7C15ull;
+    return (hash >> 32) % period == 0;
+}
+
+bool sampleEvent() noexcept
+{
+    /*A random gap, of period on average: with a fixed one, a loop whose number of events is a
+    multiple of the period would always sample the same event.*/
+    thread_local unsigned countdown = 0;
+    thread_local std::uint32_t state = 0x9E3779B9u ^ static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(&countdown));
+    if (countdown == 0)
+    {
+        unsigned const period = registry().samplingPeriod.load(std::memory_order_relaxed);
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        countdown = period <= 1 ? 0 : state % (2 * period - 1);
+        return true;
+    }
+    --countdown;
+    return false;
+}
+
+void record(TypeStats* type, Event event, std::size_t size, void const* pointer, CallSite site)
+{
+    Registry& r = registry();
+    std::uint64_t const weight = r.samplingPeriod.load(std::memory_order_relaxed);
+    type->events[static_cast<std::size_t>(event)].fetch_add(weight, std::memory_order_relaxed);
+    if (event == Event::Allocation)
+    {
+        type->bytes.fetch_add(size * weight, std::memory_order_relaxed);
+        type->sizes[bucket(size)].fetch_add(weight, std::memory_order_relaxed);
+    }
+    if (!pointer && !site.file)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(r.sampledMutex);
+    if (pointer)
+    {
+        r.births[pointer] = Clock::now();
+    }
+    if (site.file)
+    {
+        r.callSites[CallSiteKey(site.file, site.line, type, static_cast<std::size_t>(event))] += weight;
+    }
+}
+
+void recordDeallocation(TypeStats* type, void const* pointer)
+{
+    Registry& r = registry();
+    type->deallocations.fetch_add(r.samplingPeriod.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(r.sampledMutex);
+    auto const birth = r.births.find(pointer);
+    if (birth == r.births.end())
+    {
+        return;
+    }
+    auto const lifetime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - birth->second).count();
+    type->lifetimes[bucket(static_cast<std::uint64_t>(lifetime))].fetch_add(r.samplingPeriod.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    r.births.erase(birth);
+}
+
+Counts counts(TypeStats const* type)
+{
+    Counts counts;
+    for (std::size_t e = 0; e < EventCount; ++e)
+    {
+        counts.events[e] = type->events[e].load(std::memory_order_relaxed);
+    }
+    counts.deallocations = type->deallocations.load(std::memory_order_relaxed);
+    counts.bytes = type->bytes.load(std::memory_order_relaxed);
+    return counts;
+}
+}
+
+void dump(std::ostream& out)
+{
+    Registry& r = registry();
+    auto const writeHistogram = [&out](char const* name, std::atomic<std::uint64_t> const (&buckets)[BucketCount])
+    {
+        out << ",\"" << name << "\":{";
+        char const* separator = "";
+        for (std::size_t b = 0; b < BucketCount; ++b)
+        {
+            if (std::uint64_t const count = buckets[b].load(std::memory_order_relaxed))
+            {
+                out << separator << '"' << (std::uint64_t(1) << b) << "\":" << count;
+                separator = ",";
+            }
+        }
+        out << '}';
+    };
+
+    out << "{\"instrumentation\":true,\"sampling_period\":" << r.samplingPeriod.load() << ",\"types\":[";
+    {
+        std::lock_guard<std::mutex> lock(r.typesMutex);
+        char const* separator = "";
+        for (auto const& type : r.types)
+        {
+            out << separator << "{\"type\":";
+            writeString(out, type->name);
+            for (std::size_t e = 0; e < EventCount; ++e)
+            {
+                out << ",\"" << eventNames[e] << "\":" << type->events[e].load(std::memory_order_relaxed);
+            }
+            out << ",\"deallocations\":" << type->deallocations.load(std::memory_order_relaxed)
+                << ",\"bytes\":" << type->bytes.load(std::memory_order_relaxed);
+            writeHistogram("size_histogram", type->sizes);
+            writeHistogram("lifetime_ns_histogram", type->lifetimes);
+            out << '}';
+            separator = ",";
+        }
+    }
+    out << "],\"call_sites\":[";
+    {
+        std::lock_guard<std::mutex> lock(r.sampledMutex);
+        char const* separator = "";
+        for (auto const& callSite : r.callSites)
+        {
+            out << separator << "{\"file\":";
+            writeString(out, std::get<0>(callSite.first));
+            out << ",\"line\":" << std::get<1>(callSite.first) << ",\"type\":";
+            writeString(out, std::get<2>(callSite.first)->name);
+            out << ",\"event\":\"" << eventNames[std::get<3>(callSite.first)] << "\",\"count\":" << callSite.second << '}';
+            separator = ",";
+        }
+    }
+    out << "]}" << std::endl;
+}
+
+void startPeriodicDump(std::string path, std::chrono::milliseconds period)
+{
+    stopPeriodicDump();
+    Registry& r = registry();
+    r.dumper = std::thread([&r, path, period]
+    {
+        std::unique_lock<std::mutex> lock(r.dumpMutex);
+        while (!r.dumpWakeUp.wait_for(lock, period, [&r] { return r.stopping; }))
+        {
+            std::ofstream file(path, std::ios::app);
+            dump(file);
+        }
+    });
+}
+
+void stopPeriodicDump()
+{
+    Registry& r = registry();
+    if (!r.dumper.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(r.dumpMutex);
+        r.stopping = true;
+    }
+    r.dumpWakeUp.notify_all();
+    r.dumper.join();
+    r.stopping = false;
+}
+
+void setSamplingPeriod(unsigned period)
+{
+    Registry& r = registry();
+    period = period == 0 ? 1 : period;
+    if (r.samplingPeriod.exchange(period, std::memory_order_relaxed) == period)
+    {
+        return;
+    }
+    /*The objects born under the old period may not be sampled any more when they die, and their
+    births would never be erased*/
+    std::lock_guard<std::mutex> lock(r.sampledMutex);
+    r.births.clear();
+}
+
+void reset()
+{
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.typesMutex);
+        for (auto const& type : r.types)
+        {
+            for (auto& count : type->events)
+            {
+                count = 0;
+            }
+            type->deallocations = 0;
+            type->bytes = 0;
+            for (std::size_t b = 0; b < BucketCount; ++b)
+            {
+                type->sizes[b] = 0;
+                type->lifetimes[b] = 0;
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(r.sampledMutex);
+    r.callSites.clear();
+    r.births.clear();
+}
+}
+}
+#else
+namespace util
+{
+namespace instrument
+{
+void dump(std::ostream& out)
+{
+    out << "{\"instrumentation\":false}" << std::endl;
+}
+}
+}
+#endif
@@ -0,0 +1,37 @@
+#include <vector>
+#include "LinkPtr.h"
+
+namespace util
+{
+namespace detail
+{
+namespace
+{
+struct Teardown
+{
+    std::vector<PendingLink> pending;
+    bool running = false;
+};
+}
+
+void disposeLink(PendingLink link) noexcept
+{
+    thread_local Teardown teardown;
+    //Inside the destructor of a node: the loop below takes care of it
+    if (teardown.running)
+    {
+        teardown.pending.push_back(link);
+        return;
+    }
+    teardown.running = true;
+    link.dispose(link.object, link.context);
+    while (!teardown.pending.empty())
+    {
+        PendingLink const next = teardown.pending.back();
+        teardown.pending.pop_back();
+        next.dispose(next.object, next.context);
+    }
+    teardown.running = false;
+}
+}
+}
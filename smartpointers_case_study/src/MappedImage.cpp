@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include "MappedImage.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SMARTPOINTERS_MMAP
+#endif
+
+/*The file is the block of the ImageWriter from its first byte, header included, so the offsets of
+the header and those of the OffsetPtrs are the same in the writer, in the file and in the mapping.
+Where mmap isn't available, the writer reserves its capacity on the heap and MappedImage reads the
+whole file into memory: still no parsing and no allocation per node, but a read of all the pages.*/
+
+namespace util
+{
+namespace
+{
+struct ImageHeader
+{
+    char magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint64_t size;
+    std::uint64_t root;
+    std::uint64_t rootSize;
+    std::uint64_t rootAlignment;
+};
+
+char const magic[8] = {'S', 'P', 'I', 'M', 'A', 'G', 'E', '\0'};
+std::uint32_t const byteOrder = 0x01020304;
+std::uint32_t const version = 1;
+
+//The objects start on a cache line of their own
+std::size_t const headerSpace = (sizeof(ImageHeader) + 63) / 64 * 64;
+
+void release(char* base, std::size_t size) noexcept
+{
+#ifdef SMARTPOINTERS_MMAP
+    if (base)
+    {
+        munmap(base, size);
+    }
+#else
+    (void)size;
+    ::operator delete(base);
+#endif
+}
+
+[[noreturn]] void throwSystemError(char const* what, const std::string& path)
+{
+    throw std::system_error(errno, std::generic_category(), std::string(what) + path);
+}
+
+[[noreturn]] void throwInvalid(const std::string& path, char const* reason)
+{
+    throw std::runtime_error("MappedImage: " + path + " " + reason);
+}
+}
+
+ImageWriter::ImageWriter(std::size_t capacity)
+    : capacity_(std::max(capacity, headerSpace)), used_(headerSpace)
+{
+#ifdef SMARTPOINTERS_MMAP
+    void* memory = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+    base_ = static_cast<char*>(memory);
+#else
+    base_ = static_cast<char*>(::operator new(capacity_));
+#endif
+    std::memset(base_, 0, headerSpace);
+}
+
+ImageWriter::~ImageWriter()
+{
+    release(base_, capacity_);
+}
+
+void* ImageWriter::allocate(std::size_t size, std::size_t alignment)
+{
+    std::size_t const offset = (used_ + alignment - 1) / alignment * alignment;
+    if (offset > capacity_ || size > capacity_ - offset)
+    {
+        throw std::bad_alloc();
+    }
+    used_ = offset + size;
+    return base_ + offset;
+}
+
+void ImageWriter::save(const std::string& path, const void* root, std::size_t rootSize, std::size_t rootAlignment) const
+{
+    ImageHeader header;
+    std::memcpy(header.magic, magic, sizeof magic);
+    header.byteOrder = byteOrder;
+    header.version = version;
+    header.size = used_;
+    header.root = static_cast<std::uint64_t>(static_cast<char const*>(root) - base_);
+    header.rootSize = rootSize;
+    header.rootAlignment = rootAlignment;
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        throwSystemError("ImageWriter: can't create ", path);
+    }
+    bool const written = std::fwrite(&header, sizeof header, 1, file) == 1 &&
+                         std::fwrite(base_ + sizeof header, 1, used_ - sizeof header, file) == used_ - sizeof header;
+    if (std::fclose(file) != 0 || !written)
+    {
+        throwSystemError("ImageWriter: can't write ", path);
+    }
+}
+
+MappedImage::MappedImage(const std::string& path) : base_(nullptr), size_(0)
+{
+#ifdef SMARTPOINTERS_MMAP
+    int const descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        throwSystemError("MappedImage: can't open ", path);
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        int const error = errno;
+        close(descriptor);
+        errno = error;
+        throwSystemError("MappedImage: can't stat ", path);
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ >= sizeof(ImageHeader))
+    {
+        //Private and writable: the graph may be changed in place, but the file stays as it is
+        void* memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        if (memory == MAP_FAILED)
+        {
+            int const error = errno;
+            close(descriptor);
+            errno = error;
+            throwSystemError("MappedImage: can't map ", path);
+        }
+        base_ = static_cast<char*>(memory);
+    }
+    close(descriptor);
+#else
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        throwSystemError("MappedImage: can't open ", path);
+    }
+    std::fseek(file, 0, SEEK_END);
+    size_ = static_cast<std::size_t>(std::ftell(file));
+    std::fseek(file, 0, SEEK_SET);
+    base_ = static_cast<char*>(::operator new(size_));
+    bool const read = std::fread(base_, 1, size_, file) == size_;
+    std::fclose(file);
+    if (!read)
+    {
+        ::operator delete(base_);
+        throwSystemError("MappedImage: can't read ", path);
+    }
+#endif
+    char const* reason = nullptr;
+    ImageHeader header;
+    if (size_ < sizeof header)
+    {
+        reason = "is too small to be an image";
+    }
+    else
+    {
+        std::memcpy(&header, base_, sizeof header);
+        if (std::memcmp(header.magic, magic, sizeof magic) != 0)
+        {
+            reason = "is not an image";
+        }
+        else if (header.byteOrder != byteOrder || header.version != version)
+        {
+            reason = "was written by an incompatible version or platform";
+        }
+        else if (header.size != size_ || header.root < headerSpace || header.root > size_ || header.rootSize > size_ - header.root)
+        {
+            reason = "is truncated or corrupted";
+        }
+    }
+    if (reason)
+    {
+        release(base_, size_);
+        throwInvalid(path, reason);
+    }
+}
+
+MappedImage::~MappedImage()
+{
+    release(base_, size_);
+}
+
+void* MappedImage::root(std::size_t rootSize, std::size_t rootAlignment) const
+{
+    ImageHeader header;
+    std::memcpy(&header, base_, sizeof header);
+    if (header.rootSize != rootSize || header.rootAlignment != rootAlignment || header.root % rootAlignment != 0)
+    {
+        throw std::runtime_error("MappedImage: the root of the image is not of the type asked for");
+    }
+    return base_ + header.root;
+}
+}
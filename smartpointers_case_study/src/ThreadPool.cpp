@@ -0,0 +1,114 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+namespace util
+{
+namespace
+{
+//The pool and the index of the worker running on this thread, if any
+thread_local ThreadPool const* currentPool = nullptr;
+thread_local unsigned currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    unsigned const index = currentPool == this ? currentWorker : nextWorker_++ % size();
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    /*Counted once it is queued, so a push that throws leaves no count behind. A worker may take the
+    task first, and briefly bring the count below zero.*/
+    ++pending_;
+    /*A worker that goes to sleep counts itself before it checks pending_, and this checks sleepers_
+    after counting the task: one of the two sees the other. The lock waits for the sleeper to be in
+    wait(), so that the notification isn't lost.*/
+    if (sleepers_ > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+        }
+        wakeUp_.notify_one();
+    }
+}
+
+bool ThreadPool::pop(unsigned index, std::function<void()>& task)
+{
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned thief, std::function<void()>& task)
+{
+    for (unsigned offset = 1; offset < size(); ++offset)
+    {
+        Worker& victim = *workers_[(thief + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(unsigned index)
+{
+    currentPool = this;
+    currentWorker = index;
+    std::function<void()> task;
+    for (;;)
+    {
+        if (pop(index, task) || steal(index, task))
+        {
+            --pending_;
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        ++sleepers_;
+        wakeUp_.wait(lock, [this] { return pending_ > 0 || stopping_; });
+        --sleepers_;
+        if (stopping_ && pending_ <= 0)
+        {
+            return;
+        }
+    }
+}
+}
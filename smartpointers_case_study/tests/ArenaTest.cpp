@@ -0,0 +1,75 @@
+#include "Arena.h"
+#include "Engine.h"
+#include "Fridge.h"
+#include "Test.h"
+
+namespace
+{
+struct Counted
+{
+    static int alive;
+    Counted() { ++alive; }
+    ~Counted() { --alive; }
+    long value = 0;
+};
+
+int Counted::alive = 0;
+
+//An empty block still gets its own address, and is recycled like the smallest ones
+void emptyBlocks()
+{
+    util::Arena arena;
+    void* first = arena.allocate(0, 1);
+    void* second = arena.allocate(0, 1);
+    CHECK(first != second);
+    arena.deallocate(first, 0, 1);
+    CHECK(arena.allocate(0, 1) == first);
+    arena.deallocate(second, 0, 1);
+    CHECK(arena.allocate(1, 1) == second);
+}
+
+void arenaPimpl()
+{
+    util::Arena arena;
+    {
+        util::ArenaPimpl<Counted> pimpl(arena);
+        CHECK(Counted::alive == 1);
+        CHECK(&pimpl.arena() == &arena);
+        pimpl->value = 42;
+        CHECK((*pimpl).value == 42);
+    }
+    CHECK(Counted::alive == 0);
+    //The block of the impl is recycled by the next one
+    void* block = arena.allocate(sizeof(Counted), alignof(Counted));
+    arena.deallocate(block, sizeof(Counted), alignof(Counted));
+    util::ArenaPimpl<Counted> pimpl(arena);
+    CHECK(pimpl.get() == block);
+}
+
+void arenaFridge()
+{
+    util::Arena arena;
+    void* block = arena.allocate(sizeof(Engine), alignof(Engine));
+    arena.deallocate(block, sizeof(Engine), alignof(Engine));
+    {
+        //Its Engine takes the free block, and gives it back when the Fridge is destroyed
+        Fridge fridge(arena);
+        fridge.coolDown();
+        void* next = arena.allocate(sizeof(Engine), alignof(Engine));
+        CHECK(next != block);
+        arena.deallocate(next, sizeof(Engine), alignof(Engine));
+    }
+    CHECK(arena.allocate(sizeof(Engine), alignof(Engine)) == block);
+
+    //A whole batch, Fridges and Engines, released without running a destructor
+    for (int i = 0; i < 1000; ++i)
+    {
+        arena.create<Fridge>(arena)->coolDown();
+    }
+    arena.reset();
+}
+
+test::Registration empty("Arena empty blocks", emptyBlocks);
+test::Registration pimpl("Arena ArenaPimpl", arenaPimpl);
+test::Registration fridge("Arena Fridge", arenaFridge);
+}
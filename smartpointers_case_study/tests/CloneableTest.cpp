@@ -0,0 +1,112 @@
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include "Arena.h"
+#include "Cloneable.h"
+#include "Test.h"
+
+namespace
+{
+//A diamond through the virtual base Named, and a second, non-virtual interface Tagged
+class Named : public util::Cloneable<util::Abstract<Named>>
+{
+    public:
+        std::string name;
+};
+
+class Tagged : public util::Cloneable<util::Abstract<Tagged>>
+{
+    public:
+        int tag = 0;
+};
+
+class Left : public util::Cloneable<Left, util::Virtual<Named>>
+{
+    public:
+        int left = 0;
+};
+
+class Right : public util::Cloneable<Right, util::Virtual<Named>>
+{
+    public:
+        int right = 0;
+};
+
+class Both : public util::Cloneable<Both, Left, Right, Tagged>
+{
+    public:
+        Both() = default;
+        Both(const Both& other) : Named(other), Cloneable(other), child(other.child ? other.child->clone() : nullptr) {}
+        //Used by clone(arena): the child goes to the same arena
+        Both(const Both& other, util::Arena& arena)
+            : Named(other), Cloneable(other), child(other.child ? other.child->clone(arena) : nullptr) {}
+
+        util::ClonePtr<Named> child;
+};
+
+Both makeBoth()
+{
+    Both both;
+    both.name = "both";
+    both.left = 1;
+    both.right = 2;
+    both.tag = 3;
+    auto child = std::make_unique<Left>();
+    child->name = "child";
+    child->left = 4;
+    both.child = std::move(child);
+    return both;
+}
+
+bool sameState(const Named& copy, const Both& original)
+{
+    const Both* const both = dynamic_cast<const Both*>(&copy);
+    return typeid(copy) == typeid(Both) && both && both != &original
+        && both->name == "both" && both->left == 1 && both->right == 2 && both->tag == 3
+        && both->child && both->child != original.child && typeid(*both->child) == typeid(Left)
+        && both->child->name == "child" && dynamic_cast<const Left&>(*both->child).left == 4;
+}
+
+//clone() through each base gives a Both, with a pointer to the static type of the call
+void cloneThroughBases()
+{
+    Both const both = makeBoth();
+    std::unique_ptr<Both> const fromBoth = both.clone();
+    std::unique_ptr<Left> const fromLeft = static_cast<const Left&>(both).clone();
+    std::unique_ptr<Right> const fromRight = static_cast<const Right&>(both).clone();
+    std::unique_ptr<Named> const fromNamed = static_cast<const Named&>(both).clone();
+    std::unique_ptr<Tagged> const fromTagged = static_cast<const Tagged&>(both).clone();
+    CHECK(sameState(*fromBoth, both));
+    CHECK(sameState(*fromLeft, both));
+    CHECK(sameState(*fromRight, both));
+    CHECK(sameState(*fromNamed, both));
+    CHECK(typeid(*fromTagged) == typeid(Both));
+    CHECK(sameState(dynamic_cast<const Named&>(*fromTagged), both));
+}
+
+//clone(arena) uses Both(const Both&, Arena&), and the deleter gives back a block of the size of Both
+void cloneIntoArena()
+{
+    util::Arena arena;
+    Both const both = makeBoth();
+    void* block = nullptr;
+    {
+        util::ClonePtr<Right> const fromRight = static_cast<const Right&>(both).clone(arena);
+        util::ClonePtr<Named> const fromNamed = static_cast<const Named&>(both).clone(arena);
+        util::ClonePtr<Tagged> const fromTagged = static_cast<const Tagged&>(both).clone(arena);
+        CHECK(sameState(*fromRight, both));
+        CHECK(sameState(*fromNamed, both));
+        CHECK(sameState(dynamic_cast<const Named&>(*fromTagged), both));
+        CHECK(fromRight.get_deleter().arena() == &arena);
+        CHECK(dynamic_cast<const Both&>(*fromNamed).child.get_deleter().arena() == &arena);
+        block = dynamic_cast<void*>(fromRight.get());
+    }
+    //Freed last, through a Right*: its block is the first to be recycled for a Both
+    void* const reused = arena.allocate(sizeof(Both), alignof(Both));
+    CHECK(reused == block);
+    arena.deallocate(reused, sizeof(Both), alignof(Both));
+}
+
+test::Registration bases("Cloneable through every base", cloneThroughBases);
+test::Registration arenaClones("Cloneable into an arena", cloneIntoArena);
+}
@@ -0,0 +1,88 @@
+#include <utility>
+#include "CustomUniquePtr.h"
+#include "Test.h"
+
+/*The Instructions of main.cpp: a House owns the ones it builds with new and borrows a Blueprint
+from the stack. Each destructor is counted, so a double or missing delete shows.*/
+
+namespace
+{
+int destroyed = 0;
+
+class Instructions
+{
+    public:
+        virtual ~Instructions() { ++destroyed; }
+};
+
+class Sketch : public Instructions
+{
+};
+
+class Blueprint : public Instructions
+{
+};
+
+void ownedIsDestroyedOnce()
+{
+    destroyed = 0;
+    {
+        util::TaggedUniquePtr<Instructions> instructions = util::MakeConstUnique(new Sketch);
+        CHECK(instructions.owns());
+        util::TaggedUniquePtr<Instructions> moved(std::move(instructions));
+        CHECK(!instructions);
+        CHECK(destroyed == 0);
+    }
+    CHECK(destroyed == 1);
+    {
+        util::TaggedUniquePtr<Instructions> instructions = util::MakeConstUnique(new Sketch);
+        instructions.reset(new Blueprint);
+        CHECK(destroyed == 2);
+    }
+    CHECK(destroyed == 3);
+}
+
+void borrowedIsNeverDeleted()
+{
+    destroyed = 0;
+    {
+        Blueprint blueprint;
+        {
+            util::TaggedUniquePtr<Instructions> instructions = util::MakeConstUniqueNoDelete(&blueprint);
+            CHECK(!instructions.owns());
+            CHECK(instructions.get() == &blueprint);
+            util::TaggedUniquePtr<Instructions> assigned;
+            assigned = std::move(instructions);
+            CHECK(assigned.get() == &blueprint);
+            assigned.reset(&blueprint, false);
+        }
+        CHECK(destroyed == 0);
+    }
+    //The Blueprint itself, going out of scope
+    CHECK(destroyed == 1);
+}
+
+void tagSurvivesMoves()
+{
+    Blueprint blueprint;
+    util::TaggedUniquePtr<Blueprint> borrowed = util::MakeConstUniqueNoDelete(&blueprint);
+    util::TaggedUniquePtr<Instructions> converted(std::move(borrowed));
+    CHECK(!converted.owns());
+    CHECK(converted.get() == &blueprint);
+    util::TaggedUniquePtr<Instructions> owned = util::MakeConstUnique(new Sketch);
+    owned.swap(converted);
+    CHECK(owned.get() == &blueprint);
+    CHECK(!owned.owns());
+    CHECK(converted.owns());
+    util::TaggedUniquePtr<Instructions> assigned;
+    assigned = std::move(converted);
+    CHECK(assigned.owns());
+    assigned = std::move(owned);
+    CHECK(!assigned.owns());
+    CHECK(assigned.get() == &blueprint);
+}
+
+test::Registration owned("CustomUniquePtr owned Instructions are destroyed once", ownedIsDestroyedOnce);
+test::Registration borrowed("CustomUniquePtr borrowed Instructions are never deleted", borrowedIsNeverDeleted);
+test::Registration tag("CustomUniquePtr tag bit survives moves", tagSurvivesMoves);
+}
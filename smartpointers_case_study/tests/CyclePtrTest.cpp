@@ -0,0 +1,172 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "CyclePtr.h"
+#include "Test.h"
+
+namespace
+{
+//Decremented by the destructors, which may run on the background collector
+std::atomic<int> alive{0};
+
+struct House : util::Collectable
+{
+    House() { ++alive; }
+    ~House() override { --alive; }
+    void trace(util::CycleTracer& tracer) override
+    {
+        tracer(neighbour);
+        for (auto& other : neighbours)
+        {
+            tracer(other);
+        }
+    }
+    util::CyclePtr<House> neighbour;
+    std::vector<util::CyclePtr<House>> neighbours;
+};
+
+void cycles()
+{
+    alive = 0;
+    util::CycleCollector collector;
+    {
+        auto house1 = util::makeCyclePtr<House>(collector);
+        auto house2 = util::makeCyclePtr<House>(collector);
+        house1->neighbour = house2;
+        house2->neighbour = house1;
+    }
+    CHECK(alive == 2);
+    CHECK(collector.collect() == 2);
+    CHECK(alive == 0);
+    CHECK(collector.statistics().cyclesReclaimed == 1);
+}
+
+//The vectors grow under collector.lock() while the background collector traces them
+void backgroundCollection()
+{
+    alive = 0;
+    {
+        util::CycleCollector collector;
+        collector.startBackground(std::chrono::milliseconds(0), 64);
+        for (int round = 0; round < 200; ++round)
+        {
+            auto hub = util::makeCyclePtr<House>(collector);
+            for (int i = 0; i < 20; ++i)
+            {
+                auto house = util::makeCyclePtr<House>(collector);
+                house->neighbour = hub;
+                auto lock = collector.lock();
+                hub->neighbours.push_back(house);
+            }
+        }
+        collector.stopBackground();
+        collector.collect();
+        CHECK(alive == 0);
+    }
+    CHECK(alive == 0);
+}
+
+//A ring of houses needs many steps, each of which stops after its budget
+void boundedSteps()
+{
+    alive = 0;
+    util::CycleCollector collector;
+    int const size = 1000;
+    {
+        auto first = util::makeCyclePtr<House>(collector);
+        auto last = first;
+        for (int i = 1; i < size; ++i)
+        {
+            auto house = util::makeCyclePtr<House>(collector);
+            last->neighbour = house;
+            last = house;
+        }
+        last->neighbour = first;
+    }
+    CHECK(alive == size);
+    std::size_t const budget = 16;
+    std::size_t steps = 0;
+    std::size_t reclaimed = 0;
+    while (reclaimed < static_cast<std::size_t>(size) && steps < 10000)
+    {
+        reclaimed += collector.step(budget);
+        ++steps;
+    }
+    CHECK(alive == 0);
+    //Gathering the ring alone takes size / budget steps
+    CHECK(steps >= size / budget);
+    CHECK(collector.statistics().cyclesReclaimed == 1);
+}
+
+/*Copies and moves don't lock, so the threads keep moving the rings they hold while the collector
+runs: the rings that are still held must survive, and the dropped ones must all be reclaimed.*/
+void concurrentMutators()
+{
+    alive = 0;
+    {
+        util::CycleCollector collector;
+        collector.startBackground(std::chrono::milliseconds(0), 32);
+        int const threadCount = 4;
+        int const ringSize = 8;
+        std::vector<std::thread> threads;
+        std::atomic<int> survivorsChecked{0};
+        for (int t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&]
+            {
+                auto makeRing = [&]
+                {
+                    auto first = util::makeCyclePtr<House>(collector);
+                    auto last = first;
+                    for (int i = 1; i < ringSize; ++i)
+                    {
+                        auto house = util::makeCyclePtr<House>(collector);
+                        last->neighbour = house;
+                        last = std::move(house);
+                    }
+                    last->neighbour = first;
+                    return first;
+                };
+                auto kept = makeRing();
+                for (int round = 0; round < 500; ++round)
+                {
+                    auto dropped = makeRing();
+                    util::CyclePtr<House> moved = std::move(kept);
+                    moved.swap(dropped);
+                    dropped.swap(moved);
+                    kept = std::move(dropped);
+                    //Moves the edges inside the ring too, without changing its shape
+                    util::CyclePtr<House> next = std::move(kept->neighbour);
+                    kept->neighbour = std::move(next);
+                }
+                int length = 0;
+                util::CyclePtr<House> house = kept;
+                do
+                {
+                    house = house->neighbour;
+                    ++length;
+                } while (house.get() != kept.get() && length <= ringSize);
+                if (length == ringSize)
+                {
+                    ++survivorsChecked;
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        collector.stopBackground();
+        CHECK(survivorsChecked == threadCount);
+        collector.collect();
+        CHECK(alive == 0);
+    }
+    CHECK(alive == 0);
+}
+
+test::Registration cycle("CyclePtr cycles", cycles);
+test::Registration background("CyclePtr background collection", backgroundCollection);
+test::Registration bounded("CyclePtr bounded steps", boundedSteps);
+test::Registration concurrent("CyclePtr concurrent mutators", concurrentMutators);
+}
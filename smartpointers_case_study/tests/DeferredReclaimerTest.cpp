@@ -0,0 +1,159 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "DeferredReclaimer.h"
+#include "Test.h"
+
+namespace
+{
+//How many times each Tracked object was deleted, by index
+std::unique_ptr<std::atomic<int>[]> deletions;
+int tracked = 0;
+
+struct Tracked
+{
+    explicit Tracked(int index) : index(index) {}
+    ~Tracked() { ++deletions[index]; }
+    int index;
+};
+
+void track(int count)
+{
+    deletions.reset(new std::atomic<int>[count]());
+    tracked = count;
+}
+
+bool deletedOnce()
+{
+    for (int i = 0; i < tracked; ++i)
+    {
+        if (deletions[i] != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Long enough for the background thread to stay asleep while a test looks at the queue
+std::chrono::milliseconds const never = std::chrono::hours(1);
+
+void multipleProducers()
+{
+    int const threadCount = 4;
+    int const perThread = 20000;
+    track(threadCount * perThread);
+    util::DeferredReclaimer reclaimer(1024, util::DeferredReclaimer::Overflow::Wait, 64);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&reclaimer, t]
+        {
+            for (int i = 0; i < perThread; ++i)
+            {
+                reclaimer.retire(new Tracked(t * perThread + i));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    reclaimer.flush();
+    CHECK(deletedOnce());
+    util::DeferredReclaimer::Statistics const statistics = reclaimer.statistics();
+    CHECK(statistics.deferred == static_cast<std::uint64_t>(tracked));
+    CHECK(statistics.reclaimed == static_cast<std::uint64_t>(tracked));
+    CHECK(statistics.deletedInline == 0);
+}
+
+//Once the 2 cells are full, the caller deletes the objects itself
+void deleteInline()
+{
+    track(10);
+    util::DeferredReclaimer reclaimer(2, util::DeferredReclaimer::Overflow::DeleteInline, 1024, never);
+    for (int i = 0; i < tracked; ++i)
+    {
+        reclaimer.retire(new Tracked(i));
+    }
+    CHECK(reclaimer.statistics().deferred == 2);
+    CHECK(reclaimer.statistics().deletedInline == 8);
+    CHECK(deletions[0] == 0 && deletions[1] == 0);
+    CHECK(deletions[2] == 1 && deletions[9] == 1);
+    CHECK(reclaimer.drain() == 2);
+    CHECK(deletedOnce());
+}
+
+//The caller waits for the reclaimer to make room, and nothing is deleted inline
+void waitForRoom()
+{
+    track(200);
+    util::DeferredReclaimer reclaimer(2, util::DeferredReclaimer::Overflow::Wait, 1024);
+    for (int i = 0; i < tracked; ++i)
+    {
+        reclaimer.retire(new Tracked(i));
+    }
+    reclaimer.flush();
+    CHECK(deletedOnce());
+    CHECK(reclaimer.statistics().deletedInline == 0);
+    CHECK(reclaimer.statistics().waits > 0);
+}
+
+void drainQueue()
+{
+    track(100);
+    util::DeferredReclaimer reclaimer(1024, util::DeferredReclaimer::Overflow::DeleteInline, 1024, never);
+    for (int i = 0; i < tracked; ++i)
+    {
+        reclaimer.retire(new Tracked(i));
+    }
+    CHECK(deletions[0] == 0);
+    CHECK(reclaimer.drain() == static_cast<std::size_t>(tracked));
+    CHECK(deletedOnce());
+    CHECK(reclaimer.drain() == 0);
+}
+
+void pendingAtDestruction()
+{
+    track(100);
+    {
+        util::DeferredReclaimer reclaimer(1024, util::DeferredReclaimer::Overflow::DeleteInline, 1024, never);
+        for (int i = 0; i < tracked; ++i)
+        {
+            reclaimer.retire(new Tracked(i));
+        }
+        CHECK(deletions[0] == 0);
+    }
+    CHECK(deletedOnce());
+}
+
+//A deleter that flushes or drains its own reclaimer must not wait for itself
+util::DeferredReclaimer* reentered = nullptr;
+
+void reentrantDeleter()
+{
+    track(2);
+    util::DeferredReclaimer reclaimer(1024, util::DeferredReclaimer::Overflow::DeleteInline, 1024);
+    reentered = &reclaimer;
+    reclaimer.retire(new Tracked(0), [](void* pointer)
+    {
+        reentered->flush();
+        CHECK(reentered->drain() == 0);
+        delete static_cast<Tracked*>(pointer);
+    });
+    reclaimer.retire(new Tracked(1));
+    reclaimer.flush();
+    CHECK(deletedOnce());
+}
+
+test::Registration producers("DeferredReclaimer multiple producers", multipleProducers);
+test::Registration inlineDeletion("DeferredReclaimer delete inline", deleteInline);
+test::Registration waiting("DeferredReclaimer wait for room", waitForRoom);
+test::Registration drained("DeferredReclaimer drain", drainQueue);
+test::Registration destruction("DeferredReclaimer pending at destruction", pendingAtDestruction);
+test::Registration reentrant("DeferredReclaimer reentrant deleter", reentrantDeleter);
+}
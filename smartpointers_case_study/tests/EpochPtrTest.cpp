@@ -0,0 +1,52 @@
+#include <memory>
+#include <thread>
+#include "EpochPtr.h"
+#include "Test.h"
+
+namespace
+{
+int alive = 0;
+
+struct Table
+{
+    explicit Table(int version) : version(version) { ++alive; }
+    Table(const Table& other) : version(other.version) { ++alive; }
+    ~Table() { --alive; }
+    int version;
+};
+
+//Fewer versions than the batch of the writers: only the destruction of the EpochPtr deletes them
+void destructionReclaims()
+{
+    alive = 0;
+    {
+        util::EpochPtr<Table> table(std::make_unique<Table>(0));
+        for (int version = 1; version < 10; ++version)
+        {
+            table.store(std::make_unique<Table>(version));
+        }
+        table.update([](Table& t) { ++t.version; });
+        CHECK(table.read()->version == 10);
+    }
+    CHECK(alive == 0);
+}
+
+//A reader keeps its version until it is done, then the exit of the writer thread deletes it
+void threadExitReclaims()
+{
+    alive = 0;
+    util::EpochPtr<Table> table(std::make_unique<Table>(0));
+    {
+        auto const reader = table.read();
+        std::thread([&table] { table.store(std::make_unique<Table>(1)); }).join();
+        CHECK(reader->version == 0);
+        CHECK(alive == 2);
+    }
+    std::thread([&table] { table.store(std::make_unique<Table>(2)); }).join();
+    CHECK(alive == 1);
+    CHECK(table.read()->version == 2);
+}
+
+test::Registration destruction("EpochPtr destruction reclaims retired versions", destructionReclaims);
+test::Registration threadExit("EpochPtr thread exit reclaims retired versions", threadExitReclaims);
+}
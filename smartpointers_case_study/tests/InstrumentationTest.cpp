@@ -0,0 +1,93 @@
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include "Instrumentation.h"
+#include "Test.h"
+
+//UniquePtr has the same type with and without SMARTPOINTERS_INSTRUMENTATION
+static_assert(std::is_same<util::instrument::UniquePtr<int>::deleter_type, util::instrument::TrackingDelete<int>>::value,
+              "UniquePtr must name TrackingDelete in both builds");
+static_assert(util::instrument::enabled || std::is_empty<util::instrument::TrackingDelete<int>>::value,
+              "TrackingDelete must be empty without instrumentation");
+
+namespace
+{
+int destroyed = 0;
+
+struct Base
+{
+    virtual ~Base() { ++destroyed; }
+};
+
+struct Derived : Base
+{
+    int payload[4] = {};
+};
+
+struct Shared
+{
+};
+
+void uniquePtr()
+{
+    destroyed = 0;
+    {
+        util::instrument::UniquePtr<Derived> derived = util::instrument::makeUnique<Derived>();
+        util::instrument::UniquePtr<Base> base(std::move(derived));
+        CHECK(!derived);
+        CHECK(destroyed == 0);
+    }
+    CHECK(destroyed == 1);
+}
+
+/*A Derived allocated by makeUnique is counted as a Derived when it dies as a UniquePtr<Base>, and a
+pointer adopted without makeUnique is counted for its static type. Without the instrumentation,
+every count stays at zero.*/
+void uniquePtrCounts()
+{
+    using util::instrument::counts;
+    util::instrument::setSamplingPeriod(1);
+    util::instrument::reset();
+    {
+        util::instrument::UniquePtr<Base> converted(util::instrument::makeUnique<Derived>());
+        util::instrument::UniquePtr<Base> plain = util::instrument::makeUnique<Base>();
+        util::instrument::UniquePtr<Base> adopted(new Derived);
+        CHECK(counts<Derived>().deallocations == 0);
+    }
+    std::uint64_t const expected = util::instrument::enabled ? 1 : 0;
+    CHECK(counts<Derived>()[util::instrument::Event::Allocation] == expected);
+    CHECK(counts<Derived>().bytes == expected * sizeof(Derived));
+    CHECK(counts<Derived>().deallocations == expected);
+    CHECK(counts<Base>()[util::instrument::Event::Allocation] == expected);
+    CHECK(counts<Base>().deallocations == 2 * expected);
+}
+
+//One allocation holds the control block and the object, and the failed lock() is told apart
+void sharedPtrCounts()
+{
+    using util::instrument::counts;
+    using util::instrument::Event;
+    util::instrument::setSamplingPeriod(1);
+    util::instrument::reset();
+    std::weak_ptr<Shared> weak;
+    {
+        std::shared_ptr<Shared> shared = util::instrument::makeShared<Shared>();
+        weak = shared;
+        CHECK(util::instrument::lock(weak));
+    }
+    CHECK(!util::instrument::lock(weak));
+    std::uint64_t const expected = util::instrument::enabled ? 1 : 0;
+    CHECK(counts<Shared>()[Event::ControlBlock] == expected);
+    CHECK(counts<Shared>()[Event::Allocation] == expected);
+    CHECK(counts<Shared>()[Event::WeakLock] == expected);
+    CHECK(counts<Shared>()[Event::WeakLockFailure] == expected);
+    //The block is freed with the last weak_ptr
+    CHECK(counts<Shared>().deallocations == 0);
+    weak.reset();
+    CHECK(counts<Shared>().deallocations == expected);
+}
+
+test::Registration unique("Instrumentation UniquePtr", uniquePtr);
+test::Registration uniqueCounts("Instrumentation UniquePtr counts", uniquePtrCounts);
+test::Registration sharedCounts("Instrumentation shared_ptr counts", sharedPtrCounts);
+}
@@ -0,0 +1,132 @@
+#include <cstddef>
+#include <cstdint>
+#include "Arena.h"
+#include "LinkPtr.h"
+#include "Test.h"
+
+/*10M-node chains and trees, destroyed through their root. Every destructor is counted, and records
+how deep in the stack it runs: a recursive teardown would overflow the stack long before, and the
+loop of LinkPtr must keep all of them within a few frames of the root.*/
+
+namespace
+{
+constexpr std::size_t Nodes = 10000000;
+//Far more than a handful of frames, far less than what 10M nested destructors would take
+constexpr std::uintptr_t MaxStackUse = 64 * 1024;
+
+std::size_t destroyed = 0;
+std::uintptr_t deepest = 0;
+
+void recordDestruction()
+{
+    char here;
+    std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(&here);
+    if (deepest == 0 || address < deepest)
+    {
+        deepest = address;
+    }
+    ++destroyed;
+}
+
+//Destroys root and returns how many bytes of stack below this function the destructors used
+template<typename Pointer>
+std::uintptr_t destroy(Pointer& root)
+{
+    char here;
+    destroyed = 0;
+    deepest = 0;
+    root = nullptr;
+    return deepest ? reinterpret_cast<std::uintptr_t>(&here) - deepest : 0;
+}
+
+struct House
+{
+    ~House() { recordDestruction(); }
+    util::LinkPtr<House> neighbour;
+};
+
+struct ArenaHouse
+{
+    ~ArenaHouse() { recordDestruction(); }
+    util::LinkPtr<ArenaHouse, util::ArenaDeleter<ArenaHouse>> neighbour;
+};
+
+struct Node
+{
+    virtual ~Node() { recordDestruction(); }
+    util::LinkPtr<Node> left;
+    util::LinkPtr<Node> right;
+};
+
+struct Leaf : Node
+{
+    long value = 0;
+};
+
+void chain()
+{
+    util::LinkPtr<House> head;
+    for (std::size_t i = 0; i < Nodes; ++i)
+    {
+        util::LinkPtr<House> house = util::makeLink<House>();
+        house->neighbour = std::move(head);
+        head = std::move(house);
+    }
+    CHECK(destroy(head) < MaxStackUse);
+    CHECK(destroyed == Nodes);
+    CHECK(!head);
+}
+
+void arenaChain()
+{
+    util::Arena arena(1 << 20);
+    util::LinkPtr<ArenaHouse, util::ArenaDeleter<ArenaHouse>> head;
+    for (std::size_t i = 0; i < Nodes; ++i)
+    {
+        auto house = util::makeArenaLink<ArenaHouse>(arena);
+        house->neighbour = std::move(head);
+        head = std::move(house);
+    }
+    CHECK(destroy(head) < MaxStackUse);
+    CHECK(destroyed == Nodes);
+}
+
+/*A tree as deep as it gets with two children per node: a spine of Nodes whose right children are
+Leaves, held as LinkPtr<Node>*/
+void deepTree()
+{
+    util::LinkPtr<Node> root;
+    for (std::size_t i = 0; i < Nodes / 2; ++i)
+    {
+        util::LinkPtr<Node> node = util::makeLink<Node>();
+        node->left = std::move(root);
+        node->right = util::makeLink<Leaf>();
+        root = std::move(node);
+    }
+    CHECK(destroy(root) < MaxStackUse);
+    CHECK(destroyed == Nodes);
+}
+
+//Pops the head of a list with head = std::move(head->next), which must not destroy the rest
+void popFront()
+{
+    util::LinkPtr<House> head;
+    for (int i = 0; i < 3; ++i)
+    {
+        util::LinkPtr<House> house = util::makeLink<House>();
+        house->neighbour = std::move(head);
+        head = std::move(house);
+    }
+    destroyed = 0;
+    head = std::move(head->neighbour);
+    CHECK(destroyed == 1);
+    CHECK(head && head->neighbour && !head->neighbour->neighbour);
+    head.reset();
+    CHECK(destroyed == 3);
+}
+
+test::Registration chains("LinkPtr chain of 10M Houses", chain);
+test::Registration arenaChains("LinkPtr arena chain of 10M Houses", arenaChain);
+test::Registration trees("LinkPtr tree of 10M polymorphic Nodes", deepTree);
+test::Registration pops("LinkPtr pop front", popFront);
+}
@@ -0,0 +1,188 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MappedImage.h"
+#include "Test.h"
+
+/*A graph of shared_ptrs with a node shared by two parents and weak_ptr back-edges to an ancestor,
+saved as an image, mapped, and compared with the original node by node: the shared node must be
+a single node of the image, and every back-edge must point to the copy of its target.*/
+
+namespace
+{
+struct Tree
+{
+    explicit Tree(std::int64_t value) : value(value) {}
+    std::int64_t value;
+    std::weak_ptr<Tree> back;
+    std::vector<std::shared_ptr<Tree>> children;
+};
+
+struct Node
+{
+    explicit Node(std::int64_t value) : value(value) {}
+    std::int64_t value;
+    util::OffsetPtr<Node> back;
+    util::OffsetArray<util::OffsetPtr<Node>> children;
+};
+
+Node* persist(util::ImageWriter& writer, Tree const& tree)
+{
+    if (Node* copy = writer.find<Node>(&tree))
+    {
+        return copy;
+    }
+    Node* node = writer.create<Node>(tree.value);
+    writer.remember(&tree, node);
+    node->children = writer.createArray<util::OffsetPtr<Node>>(tree.children.size());
+    for (std::size_t i = 0; i < tree.children.size(); ++i)
+    {
+        node->children[i] = persist(writer, *tree.children[i]);
+    }
+    if (auto back = tree.back.lock())
+    {
+        node->back = writer.find<Node>(back.get());
+    }
+    return node;
+}
+
+//copies maps each node of the original to the node of the image that first matched it
+bool same(Tree const& tree, Node const& node, std::unordered_map<Tree const*, Node const*>& copies)
+{
+    auto const copy = copies.emplace(&tree, &node);
+    if (!copy.second)
+    {
+        return copy.first->second == &node;
+    }
+    if (tree.value != node.value || tree.children.size() != node.children.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < tree.children.size(); ++i)
+    {
+        if (!same(*tree.children[i], *node.children[i], copies))
+        {
+            return false;
+        }
+    }
+    auto const back = tree.back.lock();
+    return back ? copies.count(back.get()) && copies[back.get()] == node.back.get() : !node.back;
+}
+
+std::shared_ptr<Tree> graph()
+{
+    auto root = std::make_shared<Tree>(1);
+    auto left = std::make_shared<Tree>(2);
+    auto right = std::make_shared<Tree>(3);
+    auto shared = std::make_shared<Tree>(4);
+    auto leaf = std::make_shared<Tree>(5);
+    root->children = {left, right};
+    left->children = {shared};
+    right->children = {shared, leaf};
+    left->back = root;
+    right->back = root;
+    shared->back = root;
+    leaf->back = right;
+    return root;
+}
+
+std::string const imagePath = "MappedImageTest.image";
+std::string const otherPath = "MappedImageTest.other";
+
+std::vector<char> contents(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write(const std::string& path, std::vector<char> const& bytes)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+bool rejected(const std::string& path)
+{
+    try
+    {
+        util::MappedImage image(path);
+        return false;
+    }
+    catch (std::runtime_error const&)
+    {
+        return true;
+    }
+}
+
+void roundTrip()
+{
+    std::shared_ptr<Tree> const tree = graph();
+    {
+        util::ImageWriter writer(1 << 20);
+        writer.save(imagePath, persist(writer, *tree));
+    }
+    //Two mappings at two different addresses
+    util::MappedImage image(imagePath);
+    util::MappedImage other(imagePath);
+    for (util::MappedImage const* mapping : {&image, &other})
+    {
+        Node const* root = mapping->root<Node>();
+        std::unordered_map<Tree const*, Node const*> copies;
+        CHECK(same(*tree, *root, copies));
+        CHECK(copies.size() == 5);
+        CHECK(root->children[0]->children[0].get() == root->children[1]->children[0].get());
+        CHECK(root->children[1]->children[0]->back.get() == root);
+    }
+    std::remove(imagePath.c_str());
+}
+
+void invalidFiles()
+{
+    std::shared_ptr<Tree> const tree = graph();
+    {
+        util::ImageWriter writer(1 << 20);
+        writer.save(imagePath, persist(writer, *tree));
+    }
+    std::vector<char> const bytes = contents(imagePath);
+    CHECK(!rejected(imagePath));
+
+    write(otherPath, std::vector<char>(bytes.begin(), bytes.end() - 1));
+    CHECK(rejected(otherPath));
+    write(otherPath, std::vector<char>(bytes.begin(), bytes.begin() + 16));
+    CHECK(rejected(otherPath));
+    write(otherPath, {});
+    CHECK(rejected(otherPath));
+
+    std::vector<char> foreign(bytes.size(), 'x');
+    write(otherPath, foreign);
+    CHECK(rejected(otherPath));
+    //Right magic, other byte order
+    foreign = bytes;
+    std::swap(foreign[8], foreign[11]);
+    write(otherPath, foreign);
+    CHECK(rejected(otherPath));
+
+    util::MappedImage image(imagePath);
+    bool wrongRoot = false;
+    try
+    {
+        image.root<std::int64_t>();
+    }
+    catch (std::runtime_error const&)
+    {
+        wrongRoot = true;
+    }
+    CHECK(wrongRoot);
+    std::remove(imagePath.c_str());
+    std::remove(otherPath.c_str());
+}
+
+test::Registration trip("MappedImage round trip with shared nodes and back-edges", roundTrip);
+test::Registration invalid("MappedImage rejects truncated and foreign files", invalidFiles);
+}
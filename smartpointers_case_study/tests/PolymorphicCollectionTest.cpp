@@ -0,0 +1,124 @@
+#include <stdexcept>
+#include "PolymorphicCollection.h"
+#include "Test.h"
+
+namespace
+{
+class Instructions
+{
+    public:
+        virtual ~Instructions() = default;
+        virtual int build() const = 0;
+};
+
+class Sketch : public Instructions
+{
+    public:
+        explicit Sketch(int number = 0) : number(number) {}
+        int build() const override { return number; }
+        int number;
+};
+
+class Blueprint : public Instructions
+{
+    public:
+        int build() const override { return 100; }
+};
+
+//A handle whose object was erased must not designate the object that reuses its place
+void staleHandles()
+{
+    util::PolymorphicCollection<Instructions> instructions;
+    auto const first = instructions.emplace<Sketch>(1);
+    auto const second = instructions.emplace<Sketch>(2);
+    CHECK(instructions.erase(first));
+    CHECK(!instructions.erase(first));
+    auto const third = instructions.emplace<Sketch>(3);
+    CHECK(!instructions.contains(first));
+    CHECK(instructions.get(first) == nullptr);
+    CHECK(instructions[second].number == 2);
+    CHECK(instructions[third].number == 3);
+    CHECK(instructions.size<Sketch>() == 2);
+
+    bool thrown = false;
+    try
+    {
+        instructions[first];
+    }
+    catch (std::out_of_range const&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+//Blueprint has no segment: its handles don't find anything, and nothing is dereferenced
+void missingSegment()
+{
+    util::PolymorphicCollection<Instructions> source;
+    auto const blueprint = source.insert(Blueprint());
+    util::PolymorphicCollection<Instructions> const instructions;
+    CHECK(instructions.get(blueprint) == nullptr);
+    CHECK(instructions.size<Blueprint>() == 0);
+    bool thrown = false;
+    try
+    {
+        instructions[blueprint];
+    }
+    catch (std::out_of_range const&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+void segments()
+{
+    util::PolymorphicCollection<Instructions> instructions;
+    instructions.emplace<Sketch>(1);
+    auto const blueprint = instructions.insert(Blueprint());
+    instructions.emplace<Sketch>(2);
+    int total = 0;
+    instructions.forEach([&total](Instructions& i) { total += i.build(); });
+    CHECK(total == 103);
+    //Handed over as is: the handles remain valid in the destination
+    util::PolymorphicCollection<Instructions> destination;
+    instructions.moveSegmentTo<Blueprint>(destination);
+    CHECK(instructions.size() == 2);
+    CHECK(destination.contains(blueprint));
+    CHECK(!instructions.contains(blueprint));
+}
+
+//The segments that replace a cleared or moved one start their generations over
+void replacedSegments()
+{
+    util::PolymorphicCollection<Instructions> instructions;
+    auto const cleared = instructions.emplace<Sketch>(1);
+    instructions.clear();
+    auto const reinserted = instructions.emplace<Sketch>(2);
+    CHECK(reinserted.slot == cleared.slot);
+    CHECK(instructions.get(cleared) == nullptr);
+    CHECK(!instructions.erase(cleared));
+    CHECK(instructions[reinserted].number == 2);
+
+    util::PolymorphicCollection<Instructions> destination;
+    instructions.moveSegmentTo<Sketch>(destination);
+    auto const replacement = instructions.emplace<Sketch>(3);
+    CHECK(replacement.slot == reinserted.slot);
+    CHECK(instructions.get(reinserted) == nullptr);
+    CHECK(destination[reinserted].number == 2);
+
+    //Appended to the existing segment: the objects get new handles, the old ones expire
+    auto const appended = destination.emplace<Sketch>(4);
+    destination.moveSegmentTo<Sketch>(instructions);
+    CHECK(instructions.size<Sketch>() == 3);
+    CHECK(instructions.get(reinserted) == nullptr);
+    CHECK(instructions.get(appended) == nullptr);
+    CHECK(instructions[replacement].number == 3);
+}
+
+test::Registration stale("PolymorphicCollection stale handles", staleHandles);
+test::Registration missing("PolymorphicCollection handles of a missing segment", missingSegment);
+test::Registration moves("PolymorphicCollection segments", segments);
+test::Registration replaced("PolymorphicCollection cleared and moved segments", replacedSegments);
+}
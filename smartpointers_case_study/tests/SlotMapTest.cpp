@@ -0,0 +1,72 @@
+#include <stdexcept>
+#include "SlotMap.h"
+#include "Test.h"
+
+namespace
+{
+void expiredHandles()
+{
+    util::SlotMap<int> map;
+    util::SlotHandle const first = map.emplace(1);
+    util::SlotHandle const second = map.emplace(2);
+    CHECK(map.erase(first));
+    CHECK(!map.contains(first));
+    CHECK(map.get(first) == nullptr);
+    CHECK(!map.erase(first));
+    util::SlotHandle const third = map.emplace(3);
+    CHECK(third != first);
+    CHECK(!map.contains(first));
+    CHECK(map[second] == 2);
+    CHECK(map[third] == 3);
+}
+
+//With 2 generation bits, the slot is retired on its 4th erasure, and none of its handles may come back
+void retiredSlots()
+{
+    util::SlotMap<int, 30> map;
+    util::SlotHandle stale;
+    for (int i = 0; i < 4; ++i)
+    {
+        stale = map.emplace(i);
+        CHECK((stale.bits() & util::SlotMap<int, 30>::MaxSlots) == 0);
+        CHECK(map.erase(stale));
+    }
+    CHECK(!map.contains(stale));
+    CHECK(map.get(stale) == nullptr);
+    CHECK(!map.erase(stale));
+    util::SlotHandle const fresh = map.emplace(4);
+    CHECK((fresh.bits() & util::SlotMap<int, 30>::MaxSlots) == 1);
+    CHECK(!map.contains(stale));
+    CHECK(map.size() == 1);
+    CHECK(map[fresh] == 4);
+}
+
+//With 2 index bits there are 3 slots, the handle of the 4th would be Null
+void fullSlots()
+{
+    util::SlotMap<int, 2> map;
+    util::SlotHandle const first = map.emplace(1);
+    map.emplace(2);
+    map.emplace(3);
+    bool thrown = false;
+    try
+    {
+        map.emplace(4);
+    }
+    catch (std::length_error const&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(map.size() == 3);
+    //An erased slot can be taken again
+    CHECK(map.erase(first));
+    util::SlotHandle const fourth = map.emplace(4);
+    CHECK(map[fourth] == 4);
+    CHECK(map.size() == 3);
+}
+
+test::Registration expired("SlotMap expired handles", expiredHandles);
+test::Registration retired("SlotMap retired slots", retiredSlots);
+test::Registration full("SlotMap full", fullSlots);
+}
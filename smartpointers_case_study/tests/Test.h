@@ -0,0 +1,23 @@
+#ifndef TEST_H
+#define TEST_H
+
+/*A very small test harness in the spirit of bench/Benchmark.h: each test file registers its
+functions with a static Registration object, and tests/main.cpp runs them all (or only those
+whose name contains the filter given on the command line). CHECK records a failure and carries
+on, so one run reports every broken expectation; the process fails if any of them did.*/
+
+namespace test
+{
+using Function = void(*)();
+
+struct Registration
+{
+    Registration(char const* name, Function function);
+};
+
+void fail(char const* file, int line, char const* expression);
+}
+
+#define CHECK(expression) ((expression) ? void() : test::fail(__FILE__, __LINE__, #expression))
+
+#endif // TEST_H
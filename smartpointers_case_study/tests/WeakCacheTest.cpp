@@ -0,0 +1,79 @@
+#include <memory>
+#include "Test.h"
+#include "WeakCache.h"
+
+namespace
+{
+//The factory runs without the lock of the shard, so it may use the cache, even on the same shard
+void reentrantFactory()
+{
+    util::WeakCache<int, int> cache(0, 1);
+    auto const dependency = cache.findOrCreate(1, [] { return std::make_shared<int>(1); });
+    auto const value = cache.findOrCreate(2, [&cache]
+    {
+        auto const other = cache.find(1);
+        cache.insert(3, std::make_shared<int>(3));
+        return std::make_shared<int>(other ? *other + 1 : 0);
+    });
+    CHECK(*value == 2);
+    CHECK(cache.find(2) == value);
+}
+
+//If another object was cached while the factory ran, that one is returned
+void concurrentCreation()
+{
+    util::WeakCache<int, int> cache(0, 1);
+    std::shared_ptr<int> first;
+    auto const value = cache.findOrCreate(1, [&cache, &first]
+    {
+        first = std::make_shared<int>(1);
+        cache.insert(1, first);
+        return std::make_shared<int>(2);
+    });
+    CHECK(value == first);
+    CHECK(cache.find(1) == first);
+}
+
+//Inserting a key again replaces its retained object instead of taking another slot
+void retainedOnce()
+{
+    util::WeakCache<int, int> cache(2, 1);
+    std::weak_ptr<int> replaced;
+    {
+        auto value = std::make_shared<int>(1);
+        replaced = value;
+        cache.insert(1, value);
+        cache.insert(1, std::make_shared<int>(2));
+    }
+    CHECK(replaced.expired());
+    cache.insert(2, std::make_shared<int>(3));
+    //Both keys fit in the 2 retained slots, although nobody else holds them
+    CHECK(cache.find(1) && *cache.find(1) == 2);
+    CHECK(cache.find(2) && *cache.find(2) == 3);
+}
+
+//A looked up key gets a second chance when the CLOCK hand passes, and erase() lets go of its slot
+void clockEviction()
+{
+    util::WeakCache<int, int> cache(2, 1);
+    cache.insert(1, std::make_shared<int>(1));
+    cache.insert(2, std::make_shared<int>(2));
+    CHECK(cache.find(1));
+    cache.insert(3, std::make_shared<int>(3));
+    CHECK(!cache.find(2));
+    std::weak_ptr<int> erased = cache.find(1);
+    CHECK(!erased.expired());
+    CHECK(cache.find(3) && *cache.find(3) == 3);
+    cache.erase(1);
+    CHECK(erased.expired());
+    CHECK(!cache.find(1));
+    //4 takes the emptied slot of 1, under the hand, and 3 keeps its own
+    cache.insert(4, std::make_shared<int>(4));
+    CHECK(cache.find(3) && cache.find(4));
+}
+
+test::Registration reentrant("WeakCache reentrant factory", reentrantFactory);
+test::Registration concurrent("WeakCache concurrent creation", concurrentCreation);
+test::Registration retained("WeakCache retains a key once", retainedOnce);
+test::Registration eviction("WeakCache CLOCK eviction", clockEviction);
+}
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Test.h"
+
+namespace test
+{
+namespace
+{
+struct Entry
+{
+    char const* name;
+    Function function;
+};
+
+std::vector<Entry>& registry()
+{
+    static std::vector<Entry> entries;
+    return entries;
+}
+
+unsigned failures = 0;
+}
+
+Registration::Registration(char const* name, Function function)
+{
+    registry().push_back({name, function});
+}
+
+void fail(char const* file, int line, char const* expression)
+{
+    ++failures;
+    std::cout << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+}
+}
+
+//Usage: tests [filter]
+int main(int argc, char** argv)
+{
+    std::string const filter = argc > 1 ? argv[1] : "";
+    unsigned run = 0;
+    for (auto const& entry : test::registry())
+    {
+        if (std::string(entry.name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        std::cout << "== " << entry.name << std::endl;
+        entry.function();
+        ++run;
+    }
+    if (run == 0)
+    {
+        std::cout << "No test matches \"" << filter << "\"" << std::endl;
+        return 1;
+    }
+    std::cout << run << " tests, " << test::failures << " failed checks" << std::endl;
+    return test::failures == 0 ? 0 : 1;
+}